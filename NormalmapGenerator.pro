@@ -19,7 +19,7 @@
 #   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 #
 ################################################################################
 
-QT       += core gui
+QT       += core gui concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -42,7 +42,27 @@ SOURCES += main.cpp\
     src_generators/boxblur.cpp \
     src_generators/ssaogenerator.cpp \
     src_gui/aboutdialog.cpp \
-    src_gui/listwidget.cpp
+    src_gui/listwidget.cpp \
+    src_generators/normalfield.cpp \
+    src_generators/bufferpool.cpp \
+    src_generators/resampler.cpp \
+    src_generators/generatorprogress.cpp \
+    src_generators/heightmapgenerator.cpp \
+    src_generators/fouriertransform.cpp \
+    src_generators/photometricstereogenerator.cpp \
+    src_generators/detailnormalcombiner.cpp \
+    src_generators/seamlesstilemaker.cpp \
+    src_generators/highpassfilter.cpp \
+    src_generators/guidedfilter.cpp \
+    src_generators/roughnessgenerator.cpp \
+    src_generators/horizonmapgenerator.cpp \
+    src_generators/conemapgenerator.cpp \
+    src_generators/distancefieldgenerator.cpp \
+    src_generators/edgepadding.cpp \
+    src_generators/tilemask.cpp \
+    src_generators/atlasprocessor.cpp \
+    src_generators/udimset.cpp \
+    src_generators/imagesequence.cpp
 
 HEADERS  += src_gui/mainwindow.h \
     src_generators/intensitymap.h \
@@ -57,7 +77,27 @@ HEADERS  += src_gui/mainwindow.h \
     src_generators/ssaogenerator.h \
     src_gui/aboutdialog.h \
     src_gui/listwidget.h \
-    src_gui/clickablelabel.h
+    src_gui/clickablelabel.h \
+    src_generators/normalfield.h \
+    src_generators/bufferpool.h \
+    src_generators/resampler.h \
+    src_generators/generatorprogress.h \
+    src_generators/heightmapgenerator.h \
+    src_generators/fouriertransform.h \
+    src_generators/photometricstereogenerator.h \
+    src_generators/detailnormalcombiner.h \
+    src_generators/seamlesstilemaker.h \
+    src_generators/highpassfilter.h \
+    src_generators/guidedfilter.h \
+    src_generators/roughnessgenerator.h \
+    src_generators/horizonmapgenerator.h \
+    src_generators/conemapgenerator.h \
+    src_generators/distancefieldgenerator.h \
+    src_generators/edgepadding.h \
+    src_generators/tilemask.h \
+    src_generators/atlasprocessor.h \
+    src_generators/udimset.h \
+    src_generators/imagesequence.h
 
 FORMS    += src_gui/mainwindow.ui \
     src_gui/aboutdialog.ui
@@ -0,0 +1,72 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+// Times the SSAO generator on the normals and the depth of an image.
+// Usage: ssaobenchmark [image] [radius] [samples] [runs]
+
+#include "src_generators/ssaogenerator.h"
+#include "src_generators/normalmapgenerator.h"
+#include "src_generators/intensitymap.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QImage>
+#include <iostream>
+#include <algorithm>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+
+    const QString imagePath = args.size() > 1 ? args.at(1) : QString("tests/test.png");
+    const float radius = args.size() > 2 ? args.at(2).toFloat() : 40.0f;
+    const unsigned int samples = args.size() > 3 ? args.at(3).toUInt() : 16;
+    const int runs = args.size() > 4 ? std::max(args.at(4).toInt(), 1) : 5;
+
+    QImage input(imagePath);
+    if(input.isNull()) {
+        std::cout << "could not load " << imagePath.toStdString() << std::endl;
+        return 1;
+    }
+
+    NormalmapGenerator normalmapGenerator(IntensityMap::AVERAGE, true, true, true, false);
+    const NormalField normals = normalmapGenerator.calculateNormalField(input, NormalmapGenerator::SOBEL);
+    const IntensityMap depth(input, IntensityMap::AVERAGE);
+    QElapsedTimer timer;
+
+    std::cout << input.width() << "x" << input.height() << " px, radius " << radius << ", "
+              << samples << " samples, best of " << runs << " runs" << std::endl;
+
+    qint64 best = -1;
+    SsaoGenerator ssaoGenerator;
+
+    for(int i = 0; i < runs; i++) {
+        timer.start();
+        ssaoGenerator.calculateSsaomap(normals, depth, radius, samples, 4, false);
+        const qint64 elapsed = timer.elapsed();
+
+        best = best < 0 ? elapsed : std::min(best, elapsed);
+    }
+
+    std::cout << "ssao: " << best << " ms" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,59 @@
+################################################################################
+#   Copyright (C) 2015 by Simon Wendsche                                       #
+#                                                                              #
+#   This file is part of NormalmapGenerator.                                   #
+#                                                                              #
+#   NormalmapGenerator is free software; you can redistribute it and/or modify #
+#   it under the terms of the GNU General Public License as published by       #
+#   the Free Software Foundation; either version 3 of the License, or          #
+#   (at your option) any later version.                                        #
+#                                                                              #
+#   NormalmapGenerator is distributed in the hope that it will be useful,      #
+#   but WITHOUT ANY WARRANTY; without even the implied warranty of             #
+#   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              #
+#   GNU General Public License for more details.                               #
+#                                                                              #
+#   You should have received a copy of the GNU General Public License          #
+#   along with this program.  If not, see <http://www.gnu.org/licenses/>.      #
+#                                                                              #
+#   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 #
+################################################################################
+
+# Times the SSAO generator.
+# Run from the repository root: ssaobenchmark [image] [radius] [samples] [runs]
+
+QT       += core gui
+
+TARGET = ssaobenchmark
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+QMAKE_CXXFLAGS += -fopenmp -std=c++11
+LIBS += -fopenmp
+
+INCLUDEPATH += ../..
+
+SOURCES += main.cpp \
+    ../../src_generators/ssaogenerator.cpp \
+    ../../src_generators/normalmapgenerator.cpp \
+    ../../src_generators/intensitymap.cpp \
+    ../../src_generators/normalfield.cpp \
+    ../../src_generators/generatorprogress.cpp \
+    ../../src_generators/bufferpool.cpp \
+    ../../src_generators/guidedfilter.cpp \
+    ../../src_generators/highpassfilter.cpp \
+    ../../src_generators/resampler.cpp \
+    ../../src_generators/tilemask.cpp
+
+HEADERS += \
+    ../../src_generators/ssaogenerator.h \
+    ../../src_generators/normalmapgenerator.h \
+    ../../src_generators/intensitymap.h \
+    ../../src_generators/normalfield.h \
+    ../../src_generators/generatorprogress.h \
+    ../../src_generators/bufferpool.h \
+    ../../src_generators/guidedfilter.h \
+    ../../src_generators/highpassfilter.h \
+    ../../src_generators/resampler.h \
+    ../../src_generators/tilemask.h
@@ -0,0 +1,200 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#include "atlasprocessor.h"
+#include <cstring>
+#include <algorithm>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+AtlasProcessor::AtlasProcessor(const QList<QRect> &cells)
+    : cells(cells)
+{
+}
+
+QList<QRect> AtlasProcessor::grid(int width, int height, int columns, int rows) {
+    QList<QRect> cells;
+    if(columns < 1 || rows < 1)
+        return cells;
+
+    //the borders are rounded the same way for both neighbours, so the cells have no gaps
+    for(int row = 0; row < rows; row++) {
+        const int top = (int)((long long)row * height / rows);
+        const int bottom = (int)((long long)(row + 1) * height / rows);
+
+        for(int column = 0; column < columns; column++) {
+            const int left = (int)((long long)column * width / columns);
+            const int right = (int)((long long)(column + 1) * width / columns);
+            cells.append(QRect(left, top, right - left, bottom - top));
+        }
+    }
+
+    return cells;
+}
+
+AtlasProcessor AtlasProcessor::scaled(int fromWidth, int fromHeight, int toWidth, int toHeight) const {
+    QList<QRect> scaledCells;
+
+    for(int i = 0; i < cells.size(); i++) {
+        const QRect &cell = cells.at(i);
+        const int left = (int)((long long)cell.x() * toWidth / fromWidth);
+        const int top = (int)((long long)cell.y() * toHeight / fromHeight);
+        const int right = (int)((long long)(cell.x() + cell.width()) * toWidth / fromWidth);
+        const int bottom = (int)((long long)(cell.y() + cell.height()) * toHeight / fromHeight);
+        scaledCells.append(QRect(left, top, right - left, bottom - top));
+    }
+
+    return AtlasProcessor(scaledCells);
+}
+
+const QList<QRect>& AtlasProcessor::getCells() const {
+    return cells;
+}
+
+QImage AtlasProcessor::process(const QImage &image, std::function<QImage(const QImage&, int)> job, QRgb fill) const {
+    const QRect imageRect(0, 0, image.width(), image.height());
+    std::vector<QImage> pieces(cells.size());
+
+    //the loops of the generators in a task run on the thread of the task, so the tasks can't finish
+    //before the largest cell is done on a single thread. If that takes longer than all pixels spread
+    //over all threads (fewer cells than threads, or one dominant cell), the cells run one after
+    //the other with the parallel loops of the generators instead
+    long long totalPixels = 0;
+    long long largestCell = 0;
+    for(int i = 0; i < cells.size(); i++) {
+        const QRect cell = cells.at(i).intersected(imageRect);
+        if(cell.isEmpty())
+            continue;
+        const long long pixels = (long long)cell.width() * cell.height();
+        totalPixels += pixels;
+        largestCell = std::max(largestCell, pixels);
+    }
+
+    int threads = 1;
+#ifdef _OPENMP
+    threads = omp_get_max_threads();
+#endif
+
+    if(largestCell * threads > totalPixels) {
+        for(int i = 0; i < cells.size(); i++) {
+            const QRect cell = cells.at(i).intersected(imageRect);
+            if(!cell.isEmpty())
+                pieces[i] = job(image.copy(cell), i);
+        }
+
+        return assemble(image.width(), image.height(), pieces, fill);
+    }
+
+    //one task per cell: the cells have very different costs when only some are large,
+    //the tasks balance that without splitting a cell
+    #pragma omp parallel  // OpenMP
+    #pragma omp single
+    {
+        for(int i = 0; i < cells.size(); i++) {
+            const QRect cell = cells.at(i).intersected(imageRect);
+            if(cell.isEmpty())
+                continue;
+
+            #pragma omp task shared(pieces, image, job)
+            pieces[i] = job(image.copy(cell), i);
+        }
+    }
+
+    return assemble(image.width(), image.height(), pieces, fill);
+}
+
+QImage AtlasProcessor::assemble(int width, int height, const std::vector<QImage> &pieces, QRgb fill) const {
+    //format of the first map
+    QImage::Format format = QImage::Format_Invalid;
+    for(size_t i = 0; i < pieces.size() && format == QImage::Format_Invalid; i++) {
+        if(!pieces[i].isNull())
+            format = pieces[i].format();
+    }
+    if(format == QImage::Format_Invalid)
+        return QImage();
+
+    QImage result(width, height, format);
+    if(result.depth() == 32)
+        result.fill(fill);
+    else
+        result.fill(0);
+
+    const QRect imageRect(0, 0, width, height);
+    const int bytesPerPixel = result.depth() / 8;
+
+    for(int i = 0; i < (int)pieces.size() && i < cells.size(); i++) {
+        const QRect cell = cells.at(i).intersected(imageRect);
+        if(pieces[i].isNull() || pieces[i].width() != cell.width() || pieces[i].height() != cell.height())
+            continue;
+
+        const QImage piece = pieces[i].format() == format ? pieces[i] : pieces[i].convertToFormat(format);
+
+        for(int y = 0; y < cell.height(); y++) {
+            std::memcpy(result.scanLine(cell.y() + y) + (size_t)cell.x() * bytesPerPixel,
+                        piece.constScanLine(y), (size_t)cell.width() * bytesPerPixel);
+        }
+    }
+
+    return result;
+}
+
+NormalField AtlasProcessor::assemble(int width, int height, const std::vector<NormalField> &pieces) const {
+    NormalField result(width, height);
+    const QRect imageRect(0, 0, width, height);
+
+    for(int i = 0; i < (int)pieces.size() && i < cells.size(); i++) {
+        const QRect cell = cells.at(i).intersected(imageRect);
+        const NormalField &piece = pieces[i];
+        if(piece.isNull() || (int)piece.getWidth() != cell.width() || (int)piece.getHeight() != cell.height())
+            continue;
+
+        for(int y = 0; y < cell.height(); y++) {
+            const size_t from = (size_t)y * cell.width();
+            const size_t to = (size_t)(cell.y() + y) * width + cell.x();
+            const size_t bytes = (size_t)cell.width() * sizeof(float);
+            std::memcpy(result.planeX() + to, piece.planeX() + from, bytes);
+            std::memcpy(result.planeY() + to, piece.planeY() + from, bytes);
+            std::memcpy(result.planeZ() + to, piece.planeZ() + from, bytes);
+        }
+    }
+
+    return result;
+}
+
+IntensityMap AtlasProcessor::assemble(int width, int height, const std::vector<IntensityMap> &pieces) const {
+    IntensityMap result(width, height);
+    const QRect imageRect(0, 0, width, height);
+
+    for(int i = 0; i < (int)pieces.size() && i < cells.size(); i++) {
+        const QRect cell = cells.at(i).intersected(imageRect);
+        const IntensityMap &piece = pieces[i];
+        if(piece.isNull() || (int)piece.getWidth() != cell.width() || (int)piece.getHeight() != cell.height())
+            continue;
+
+        for(int y = 0; y < cell.height(); y++) {
+            std::memcpy(result.data() + (size_t)(cell.y() + y) * width + cell.x(),
+                        piece.data() + (size_t)y * cell.width(), (size_t)cell.width() * sizeof(double));
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,64 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#ifndef ATLASPROCESSOR_H
+#define ATLASPROCESSOR_H
+
+#include <QImage>
+#include <QList>
+#include <QRect>
+#include <functional>
+#include <vector>
+#include "normalfield.h"
+#include "intensitymap.h"
+
+// Texture atlases and sprite sheets: every cell is calculated on its own, with its own
+// tileable or clamped borders, so kernels, blurs and the large detail map do not reach
+// into the neighbouring cells. Many similar cells run as parallel tasks, the parallel loops
+// of the generators inside a cell run on the thread of its task. A few or very uneven cells
+// run one after the other, each with the parallel loops of the generators.
+class AtlasProcessor
+{
+public:
+    //cells in pixels of the image the jobs are run on
+    explicit AtlasProcessor(const QList<QRect> &cells);
+    //columns x rows cells of the same size covering the image
+    static QList<QRect> grid(int width, int height, int columns, int rows);
+    //the cells on an image of another size (e.g. the scaled normalmap), adjacent cells stay adjacent
+    AtlasProcessor scaled(int fromWidth, int fromHeight, int toWidth, int toHeight) const;
+    const QList<QRect>& getCells() const;
+
+    //job gets a copy of every cell (and the index of the cell) and returns the map of it in the same size,
+    //the maps are put together into an image of the input's size. Pixels outside of all cells get fill.
+    //The job is run concurrently, it has to use its own generators
+    QImage process(const QImage &image, std::function<QImage(const QImage&, int)> job, QRgb fill = 0) const;
+    //puts the maps of the cells together
+    QImage assemble(int width, int height, const std::vector<QImage> &pieces, QRgb fill = 0) const;
+    //puts the float normals of the cells together, pixels outside of all cells are flat
+    NormalField assemble(int width, int height, const std::vector<NormalField> &pieces) const;
+    //puts the intensities of the cells together, pixels outside of all cells are 0
+    IntensityMap assemble(int width, int height, const std::vector<IntensityMap> &pieces) const;
+
+private:
+    QList<QRect> cells;
+};
+
+#endif // ATLASPROCESSOR_H
@@ -0,0 +1,145 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#include "bufferpool.h"
+#include <cstdlib>
+#include <cstdint>
+#include <new>
+
+BufferPool::BufferPool()
+    : maxCachedBytes(512 * 1024 * 1024)
+{
+    resetStats();
+    stats.bytesCached = 0;
+}
+
+BufferPool::~BufferPool() {
+    clear();
+}
+
+BufferPool& BufferPool::instance() {
+    static BufferPool pool;
+    return pool;
+}
+
+void* BufferPool::allocate(size_t bytes) {
+    if(bytes < MIN_POOLED_SIZE)
+        return allocateAligned(bytes);
+
+    const size_t size = bucketSize(bytes);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::map< size_t, std::vector<void*> >::iterator bucket = freeBuffers.find(size);
+
+        if(bucket != freeBuffers.end() && !bucket->second.empty()) {
+            void *buffer = bucket->second.back();
+            bucket->second.pop_back();
+
+            stats.hits++;
+            stats.bytesReused += size;
+            stats.pageFaultsAvoided += size / PAGE_SIZE;
+            stats.bytesCached -= size;
+            return buffer;
+        }
+
+        stats.misses++;
+    }
+
+    return allocateAligned(size);
+}
+
+void BufferPool::release(void *buffer, size_t bytes) {
+    if(buffer == 0)
+        return;
+
+    if(bytes < MIN_POOLED_SIZE) {
+        freeAligned(buffer);
+        return;
+    }
+
+    const size_t size = bucketSize(bytes);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        //keep the buffer for later, as long as the pool does not grow too large
+        if(stats.bytesCached + size <= maxCachedBytes) {
+            freeBuffers[size].push_back(buffer);
+            stats.bytesCached += size;
+            return;
+        }
+    }
+
+    freeAligned(buffer);
+}
+
+//gives all cached buffers back to the OS
+void BufferPool::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::map< size_t, std::vector<void*> >::iterator bucket;
+    for(bucket = freeBuffers.begin(); bucket != freeBuffers.end(); ++bucket) {
+        for(size_t i = 0; i < bucket->second.size(); i++) {
+            freeAligned(bucket->second[i]);
+        }
+    }
+
+    freeBuffers.clear();
+    stats.bytesCached = 0;
+}
+
+void BufferPool::setMaxCachedBytes(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    maxCachedBytes = bytes;
+}
+
+BufferPool::Stats BufferPool::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+void BufferPool::resetStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.hits = 0;
+    stats.misses = 0;
+    stats.bytesReused = 0;
+    stats.pageFaultsAvoided = 0;
+}
+
+size_t BufferPool::bucketSize(size_t bytes) const {
+    return ((bytes + BUCKET_GRANULARITY - 1) / BUCKET_GRANULARITY) * BUCKET_GRANULARITY;
+}
+
+//allocates with ALIGNMENT bytes alignment, the original pointer is stored in front of the buffer
+void* BufferPool::allocateAligned(size_t bytes) const {
+    void *raw = malloc(bytes + ALIGNMENT + sizeof(void*));
+    if(raw == 0)
+        throw std::bad_alloc();
+
+    uintptr_t aligned = ((uintptr_t)raw + sizeof(void*) + ALIGNMENT - 1) & ~(uintptr_t)(ALIGNMENT - 1);
+    ((void**)aligned)[-1] = raw;
+    return (void*)aligned;
+}
+
+void BufferPool::freeAligned(void *buffer) const {
+    free(((void**)buffer)[-1]);
+}
@@ -0,0 +1,113 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <vector>
+
+// Recycles the large, equally sized buffers that every generation allocates (intensity maps,
+// normal planes, blur copies, ...). Released buffers are kept in buckets by their size and
+// handed out again instead of going back to the OS, which saves the mmap/munmap and the page
+// faults on the first write for every image of a batch. Small buffers are not pooled.
+class BufferPool
+{
+public:
+    struct Stats {
+        size_t hits;
+        size_t misses;
+        size_t bytesReused;
+        size_t pageFaultsAvoided;
+        size_t bytesCached;
+    };
+
+    static BufferPool& instance();
+
+    void* allocate(size_t bytes);
+    void release(void *buffer, size_t bytes);
+    void clear();
+    void setMaxCachedBytes(size_t bytes);
+    Stats getStats() const;
+    void resetStats();
+
+private:
+    //buffers below this size are allocated directly
+    static const size_t MIN_POOLED_SIZE = 64 * 1024;
+    //pooled sizes are rounded up to multiples of this
+    static const size_t BUCKET_GRANULARITY = 64 * 1024;
+    static const size_t ALIGNMENT = 64;
+    static const size_t PAGE_SIZE = 4096;
+
+    mutable std::mutex mutex;
+    std::map< size_t, std::vector<void*> > freeBuffers;
+    size_t maxCachedBytes;
+    Stats stats;
+
+    BufferPool();
+    ~BufferPool();
+    BufferPool(const BufferPool&);
+    BufferPool& operator=(const BufferPool&);
+
+    size_t bucketSize(size_t bytes) const;
+    void* allocateAligned(size_t bytes) const;
+    void freeAligned(void *buffer) const;
+};
+
+// std allocator that takes its memory from the BufferPool,
+// e.g. std::vector<double, PoolAllocator<double> >
+template<typename T>
+class PoolAllocator
+{
+public:
+    typedef T value_type;
+
+    template<typename U>
+    struct rebind {
+        typedef PoolAllocator<U> other;
+    };
+
+    PoolAllocator() {}
+    template<typename U>
+    PoolAllocator(const PoolAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(BufferPool::instance().allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T *buffer, size_t n) {
+        BufferPool::instance().release(buffer, n * sizeof(T));
+    }
+};
+
+template<typename T, typename U>
+bool operator==(const PoolAllocator<T>&, const PoolAllocator<U>&) {
+    return true;
+}
+
+template<typename T, typename U>
+bool operator!=(const PoolAllocator<T>&, const PoolAllocator<U>&) {
+    return false;
+}
+
+#endif // BUFFERPOOL_H
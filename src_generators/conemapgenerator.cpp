@@ -0,0 +1,309 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#include "conemapgenerator.h"
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+//size of the leaf blocks of the pyramid and of the tiles the pixels are processed in
+static const int CONEMAP_BLOCK = 8;
+//widest cone stored
+static const float CONEMAP_MAX_RATIO = 1.0f;
+//depth first search: at most 4 nodes per level are waiting
+static const int CONEMAP_MAX_STACK = 4 * 32;
+
+namespace {
+struct ConeMapNode {
+    int level;
+    int x;
+    int y;
+    float bound;
+};
+}
+
+ConeMapGenerator::ConeMapGenerator()
+    : progress(0), width(0), height(0), tileable(false), aspect(1.0f)
+{
+}
+
+//optional, tiles are reported to it and it can cancel the calculation
+void ConeMapGenerator::setProgress(GeneratorProgress *progress) {
+    this->progress = progress;
+}
+
+QImage ConeMapGenerator::calculateConeMap(const IntensityMap &heightmap, bool tileable) {
+    width = heightmap.getWidth();
+    height = heightmap.getHeight();
+    if(width == 0 || height == 0)
+        return QImage();
+
+    this->tileable = tileable;
+    aspect = (float)width / height;
+
+    const double *source = heightmap.data();
+    heights.assign((size_t)width * height, 0.0f);
+
+    #pragma omp parallel for  // OpenMP
+    for(int y = 0; y < height; y++) {
+        for(int x = 0; x < width; x++) {
+            heights[(size_t)y * width + x] = (float)(source[(size_t)y * width + x] * width);
+        }
+    }
+
+    buildMaxPyramid();
+
+    const int tilesX = (width + CONEMAP_BLOCK - 1) / CONEMAP_BLOCK;
+    const int tilesY = (height + CONEMAP_BLOCK - 1) / CONEMAP_BLOCK;
+    if(progress)
+        progress->addWork((long long)tilesX * tilesY);
+
+    QImage result(width, height, QImage::Format_RGB32);
+    const int bytesPerLine = result.bytesPerLine();
+    uchar *bits = result.bits();
+
+    //the pixels of a tile share most of their blockers: the blocker of the previous pixel
+    //gives a narrow starting cone, so little of the pyramid has to be searched
+    #pragma omp parallel for schedule(dynamic)  // OpenMP
+    for(int tile = 0; tile < tilesX * tilesY; tile++) {
+        if(progress && progress->isCanceled())
+            continue;
+
+        const int x0 = (tile % tilesX) * CONEMAP_BLOCK;
+        const int y0 = (tile / tilesX) * CONEMAP_BLOCK;
+        const int x1 = std::min(x0 + CONEMAP_BLOCK, width);
+        const int y1 = std::min(y0 + CONEMAP_BLOCK, height);
+        int blocker = -1;
+
+        for(int y = y0; y < y1; y++) {
+            QRgb *line = (QRgb*)(bits + (size_t)y * bytesPerLine);
+
+            for(int x = x0; x < x1; x++) {
+                const float ratio = std::sqrt(coneRatioSquared(x, y, blocker));
+                const int h = (int)(source[(size_t)y * width + x] * 255.0 + 0.5);
+                const int c = (int)(std::sqrt(ratio / CONEMAP_MAX_RATIO) * 255.0f + 0.5f);
+                line[x] = qRgb(std::max(0, std::min(h, 255)), c, 0);
+            }
+        }
+
+        if(progress)
+            progress->advance();
+    }
+
+    heights.clear();
+    heights.shrink_to_fit();
+    maxLevels.clear();
+
+    return result;
+}
+
+void ConeMapGenerator::buildMaxPyramid() {
+    maxLevels.clear();
+    levelWidths.clear();
+    levelHeights.clear();
+
+    int levelWidth = (width + CONEMAP_BLOCK - 1) / CONEMAP_BLOCK;
+    int levelHeight = (height + CONEMAP_BLOCK - 1) / CONEMAP_BLOCK;
+    std::vector<float> blocks((size_t)levelWidth * levelHeight);
+
+    #pragma omp parallel for  // OpenMP
+    for(int by = 0; by < levelHeight; by++) {
+        for(int bx = 0; bx < levelWidth; bx++) {
+            const int x1 = std::min((bx + 1) * CONEMAP_BLOCK, width);
+            const int y1 = std::min((by + 1) * CONEMAP_BLOCK, height);
+            float maximum = heights[(size_t)by * CONEMAP_BLOCK * width + bx * CONEMAP_BLOCK];
+
+            for(int y = by * CONEMAP_BLOCK; y < y1; y++) {
+                for(int x = bx * CONEMAP_BLOCK; x < x1; x++)
+                    maximum = std::max(maximum, heights[(size_t)y * width + x]);
+            }
+
+            blocks[(size_t)by * levelWidth + bx] = maximum;
+        }
+    }
+
+    maxLevels.push_back(blocks);
+    levelWidths.push_back(levelWidth);
+    levelHeights.push_back(levelHeight);
+
+    while(levelWidth > 1 || levelHeight > 1) {
+        const std::vector<float> &below = maxLevels.back();
+        const int belowWidth = levelWidth;
+        const int belowHeight = levelHeight;
+        levelWidth = (levelWidth + 1) / 2;
+        levelHeight = (levelHeight + 1) / 2;
+        std::vector<float> level((size_t)levelWidth * levelHeight);
+
+        for(int y = 0; y < levelHeight; y++) {
+            for(int x = 0; x < levelWidth; x++) {
+                const int belowX = std::min(2 * x + 1, belowWidth - 1);
+                const int belowY = std::min(2 * y + 1, belowHeight - 1);
+                level[(size_t)y * levelWidth + x] = std::max(
+                            std::max(below[(size_t)2 * y * belowWidth + 2 * x], below[(size_t)2 * y * belowWidth + belowX]),
+                            std::max(below[(size_t)belowY * belowWidth + 2 * x], below[(size_t)belowY * belowWidth + belowX]));
+            }
+        }
+
+        maxLevels.push_back(level);
+        levelWidths.push_back(levelWidth);
+        levelHeights.push_back(levelHeight);
+    }
+}
+
+//squared distance from the pixel to the nearest pixel of the node, around the borders when tileable
+float ConeMapGenerator::nodeDistanceSquared(int x, int y, int level, int nodeX, int nodeY) const {
+    const int size = CONEMAP_BLOCK << level;
+    const int left = nodeX * size;
+    const int top = nodeY * size;
+    const int right = std::min(left + size, width) - 1;
+    const int bottom = std::min(top + size, height) - 1;
+
+    int dx = std::max(0, std::max(left - x, x - right));
+    int dy = std::max(0, std::max(top - y, y - bottom));
+    if(tileable) {
+        dx = std::min(dx, std::max(0, std::max(left + width - x, x - right - width)));
+        dx = std::min(dx, std::max(0, std::max(left - width - x, x - right + width)));
+        dy = std::min(dy, std::max(0, std::max(top + height - y, y - bottom - height)));
+        dy = std::min(dy, std::max(0, std::max(top - height - y, y - bottom + height)));
+    }
+
+    const float scaledY = dy * aspect;
+    return (float)dx * dx + scaledY * scaledY;
+}
+
+//squared ratio of the widest free cone on the pixel. blocker: pixel index of the last blocker
+//found (tried first, -1 if none) and set to the blocker of this pixel
+float ConeMapGenerator::coneRatioSquared(int x, int y, int &blocker) const {
+    const float h = heights[(size_t)y * width + x];
+    float best = CONEMAP_MAX_RATIO * CONEMAP_MAX_RATIO;
+
+    if(blocker >= 0) {
+        const float rise = heights[blocker] - h;
+        if(rise > 0.0f) {
+            int dx = std::abs(blocker % width - x);
+            int dy = std::abs(blocker / width - y);
+            if(tileable) {
+                dx = std::min(dx, width - dx);
+                dy = std::min(dy, height - dy);
+            }
+            const float scaledY = dy * aspect;
+            best = std::min(best, ((float)dx * dx + scaledY * scaledY) / (rise * rise));
+        }
+    }
+
+    ConeMapNode stack[CONEMAP_MAX_STACK];
+    int stackSize = 0;
+    const int topLevel = (int)maxLevels.size() - 1;
+    stack[stackSize++] = { topLevel, 0, 0, 0.0f };
+
+    while(stackSize > 0) {
+        const ConeMapNode node = stack[--stackSize];
+        //the cone became narrower since the node was pushed
+        if(node.bound >= best)
+            continue;
+
+        if(node.level == 0) {
+            //leaf block: exact ratios of its pixels
+            const int left = node.x * CONEMAP_BLOCK;
+            const int top = node.y * CONEMAP_BLOCK;
+            const int right = std::min(left + CONEMAP_BLOCK, width);
+            const int bottom = std::min(top + CONEMAP_BLOCK, height);
+            float blockBest = best;
+
+            for(int qy = top; qy < bottom; qy++) {
+                int dy = std::abs(qy - y);
+                if(tileable)
+                    dy = std::min(dy, height - dy);
+                const float scaledY = dy * aspect;
+                const float dy2 = scaledY * scaledY;
+                const float *row = &heights[(size_t)qy * width];
+
+                #pragma omp simd reduction(min:blockBest)
+                for(int qx = left; qx < right; qx++) {
+                    int dx = std::abs(qx - x);
+                    if(tileable)
+                        dx = std::min(dx, width - dx);
+                    const float rise = row[qx] - h;
+                    const float ratio = rise > 0.0f ? ((float)dx * dx + dy2) / (rise * rise) : blockBest;
+                    blockBest = std::min(blockBest, ratio);
+                }
+            }
+
+            //the blocker itself is only searched for when the block made the cone narrower
+            if(blockBest < best) {
+                best = blockBest;
+                for(int qy = top; qy < bottom; qy++) {
+                    for(int qx = left; qx < right; qx++) {
+                        const float rise = heights[(size_t)qy * width + qx] - h;
+                        if(rise <= 0.0f)
+                            continue;
+                        int dx = std::abs(qx - x);
+                        int dy = std::abs(qy - y);
+                        if(tileable) {
+                            dx = std::min(dx, width - dx);
+                            dy = std::min(dy, height - dy);
+                        }
+                        const float scaledY = dy * aspect;
+                        if(((float)dx * dx + scaledY * scaledY) / (rise * rise) == best)
+                            blocker = qy * width + qx;
+                    }
+                }
+            }
+            continue;
+        }
+
+        //children that can still hold a blocker, the nearest one is searched first
+        const int childLevel = node.level - 1;
+        const std::vector<float> &maxima = maxLevels[childLevel];
+        const int childWidth = levelWidths[childLevel];
+        const int childHeight = levelHeights[childLevel];
+        ConeMapNode children[4];
+        int childCount = 0;
+
+        for(int i = 0; i < 4; i++) {
+            const int childX = 2 * node.x + (i & 1);
+            const int childY = 2 * node.y + (i >> 1);
+            if(childX >= childWidth || childY >= childHeight)
+                continue;
+
+            const float rise = maxima[(size_t)childY * childWidth + childX] - h;
+            if(rise <= 0.0f)
+                continue;
+
+            const float bound = nodeDistanceSquared(x, y, childLevel, childX, childY) / (rise * rise);
+            if(bound >= best)
+                continue;
+
+            //sorted from the highest bound to the lowest
+            int position = childCount++;
+            while(position > 0 && children[position - 1].bound < bound) {
+                children[position] = children[position - 1];
+                position--;
+            }
+            children[position] = { childLevel, childX, childY, bound };
+        }
+
+        for(int i = 0; i < childCount; i++)
+            stack[stackSize++] = children[i];
+    }
+
+    return best;
+}
@@ -0,0 +1,65 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#ifndef CONEMAPGENERATOR_H
+#define CONEMAPGENERATOR_H
+
+#include <QImage>
+#include <vector>
+#include "intensitymap.h"
+#include "generatorprogress.h"
+#include "bufferpool.h"
+
+// Cone step maps for relief mapping: for every pixel the widest cone standing on the surface
+// that contains no higher part of the height field, as ratio of radius (in texture coordinates)
+// to height (intensity 0..1), limited to 1.
+// Instead of testing every pixel against every other one, the heights are searched through
+// a pyramid of block maxima: a block whose maximum can not give a narrower cone than the
+// best one so far is skipped without looking at its pixels.
+class ConeMapGenerator
+{
+public:
+    ConeMapGenerator();
+    //height in the red channel, square root of the cone ratio in the green channel (more precision for narrow cones)
+    QImage calculateConeMap(const IntensityMap &heightmap, bool tileable);
+    void setProgress(GeneratorProgress *progress);
+
+private:
+    GeneratorProgress *progress;
+
+    int width;
+    int height;
+    bool tileable;
+    //vertical distances are scaled to texture coordinates of the same size as horizontal ones
+    float aspect;
+    //heights in pixels (intensity 1 is the image width)
+    std::vector< float, PoolAllocator<float> > heights;
+    //maxima of the leaf blocks, then of 2x2 nodes of the level below up to a single node
+    std::vector< std::vector<float> > maxLevels;
+    std::vector<int> levelWidths;
+    std::vector<int> levelHeights;
+
+    void buildMaxPyramid();
+    float coneRatioSquared(int x, int y, int &blocker) const;
+    float nodeDistanceSquared(int x, int y, int level, int nodeX, int nodeY) const;
+};
+
+#endif // CONEMAPGENERATOR_H
@@ -0,0 +1,103 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#include "detailnormalcombiner.h"
+#include "resampler.h"
+#include <cmath>
+
+//keeps the reorientation finite for base normals that point (almost) straight down
+static const float DETAILNORMALCOMBINER_MIN_BASE_Z = 1.0e-3f;
+
+DetailNormalCombiner::DetailNormalCombiner(bool tileable)
+    : tileable(tileable), progress(0)
+{
+}
+
+//optional, combined rows are reported to it and it can cancel the calculation
+void DetailNormalCombiner::setProgress(GeneratorProgress *progress) {
+    this->progress = progress;
+}
+
+NormalField DetailNormalCombiner::combine(const NormalField &base, const NormalField &detail) const {
+    const int width = detail.getWidth();
+    const int height = detail.getHeight();
+
+    if(base.isNull() || detail.isNull())
+        return detail;
+
+    NormalField baseScaled;
+    if((int)base.getWidth() != width || (int)base.getHeight() != height)
+        baseScaled = Resampler(Resampler::MITCHELL, tileable).scaled(base, width, height);
+    const NormalField &baseSized = baseScaled.isNull() ? base : baseScaled;
+
+    if(progress)
+        progress->addWork(height);
+
+    NormalField result(width, height);
+    const float *baseX = baseSized.planeX();
+    const float *baseY = baseSized.planeY();
+    const float *baseZ = baseSized.planeZ();
+    const float *detailX = detail.planeX();
+    const float *detailY = detail.planeY();
+    const float *detailZ = detail.planeZ();
+    float *resultX = result.planeX();
+    float *resultY = result.planeY();
+    float *resultZ = result.planeZ();
+
+    #pragma omp parallel for  // OpenMP
+    for(int y = 0; y < height; y++) {
+        if(progress && progress->isCanceled())
+            continue;
+
+        const size_t row = (size_t)y * width;
+
+        //decoded 8 bit maps and resampled normals are not unit length, all of them are normalized in this one pass
+        #pragma omp simd
+        for(size_t i = row; i < row + width; i++) {
+            const float baseInvLength = 1.0f / std::sqrt(baseX[i] * baseX[i] + baseY[i] * baseY[i] + baseZ[i] * baseZ[i] + 1.0e-12f);
+            const float detailInvLength = 1.0f / std::sqrt(detailX[i] * detailX[i] + detailY[i] * detailY[i] + detailZ[i] * detailZ[i] + 1.0e-12f);
+
+            //t = base + (0, 0, 1), u = detail * (-1, -1, 1)
+            const float tx = baseX[i] * baseInvLength;
+            const float ty = baseY[i] * baseInvLength;
+            const float tz = std::max(baseZ[i] * baseInvLength + 1.0f, DETAILNORMALCOMBINER_MIN_BASE_Z);
+            const float ux = -detailX[i] * detailInvLength;
+            const float uy = -detailY[i] * detailInvLength;
+            const float uz = detailZ[i] * detailInvLength;
+
+            //r = t * dot(t, u) / t.z - u
+            const float scale = (tx * ux + ty * uy + tz * uz) / tz;
+            const float rx = tx * scale - ux;
+            const float ry = ty * scale - uy;
+            const float rz = tz * scale - uz;
+
+            const float invLength = 1.0f / std::sqrt(rx * rx + ry * ry + rz * rz + 1.0e-12f);
+            resultX[i] = rx * invLength;
+            resultY[i] = ry * invLength;
+            resultZ[i] = rz * invLength;
+        }
+
+        if(progress)
+            progress->advance();
+    }
+
+    return result;
+}
@@ -0,0 +1,44 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#ifndef DETAILNORMALCOMBINER_H
+#define DETAILNORMALCOMBINER_H
+
+#include "normalfield.h"
+#include "generatorprogress.h"
+
+// Puts detail normals on top of an existing base normalmap (e.g. baked from a mesh)
+// with reoriented normal mapping: the detail normal is rotated by the rotation that takes
+// the up vector to the base normal, so the details follow the curvature of the base.
+class DetailNormalCombiner
+{
+public:
+    DetailNormalCombiner(bool tileable = false);
+    //the base map is resampled to the size of the detail map if necessary
+    NormalField combine(const NormalField &base, const NormalField &detail) const;
+    void setProgress(GeneratorProgress *progress);
+
+private:
+    bool tileable;
+    GeneratorProgress *progress;
+};
+
+#endif // DETAILNORMALCOMBINER_H
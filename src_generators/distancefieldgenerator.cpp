@@ -0,0 +1,262 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#include "distancefieldgenerator.h"
+#include <cmath>
+#include <algorithm>
+
+//squared distance of pixels without a site in reach
+static const float DISTANCEFIELD_INFINITY = 1.0e20f;
+//columns gathered together, they share the cache lines of the rows
+static const int DISTANCEFIELD_COLUMN_BLOCK = 16;
+
+DistanceFieldGenerator::DistanceFieldGenerator()
+    : progress(0)
+{
+}
+
+//optional, lines are reported to it and it can cancel the calculation
+void DistanceFieldGenerator::setProgress(GeneratorProgress *progress) {
+    this->progress = progress;
+}
+
+QImage DistanceFieldGenerator::calculateDistanceField(const QImage &input, double spread, bool tileable, bool sixteenBit) {
+    const int width = input.width();
+    const int height = input.height();
+    if(width == 0 || height == 0)
+        return QImage();
+
+    const QImage argb = input.convertToFormat(QImage::Format_ARGB32);
+    const size_t size = (size_t)width * height;
+    const int columnBlocks = (width + DISTANCEFIELD_COLUMN_BLOCK - 1) / DISTANCEFIELD_COLUMN_BLOCK;
+    if(progress)
+        progress->addWork(2LL * (columnBlocks + height));
+
+    //squared distances to the nearest outside pixel (for the inside) and to the nearest inside pixel
+    std::vector< float, PoolAllocator<float> > toOutside(size);
+    std::vector< float, PoolAllocator<float> > toInside(size);
+
+    #pragma omp parallel for  // OpenMP
+    for(int y = 0; y < height; y++) {
+        const QRgb *line = (const QRgb*)argb.constScanLine(y);
+        for(int x = 0; x < width; x++) {
+            const bool inside = qAlpha(line[x]) >= 128;
+            toOutside[(size_t)y * width + x] = inside ? DISTANCEFIELD_INFINITY : 0.0f;
+            toInside[(size_t)y * width + x] = inside ? 0.0f : DISTANCEFIELD_INFINITY;
+        }
+    }
+
+    transform(toOutside, width, height, tileable);
+    transform(toInside, width, height, tileable);
+
+    if(progress && progress->isCanceled())
+        return QImage();
+
+    QImage result(width, height, sixteenBit ? QImage::Format_Grayscale16 : QImage::Format_Grayscale8);
+    const float maxValue = sixteenBit ? 65535.0f : 255.0f;
+    const float scale = 0.5f / (float)spread;
+
+    #pragma omp parallel for  // OpenMP
+    for(int y = 0; y < height; y++) {
+        uchar *line = result.scanLine(y);
+
+        for(int x = 0; x < width; x++) {
+            const size_t i = (size_t)y * width + x;
+            //distances between pixel centers, the edge lies half a pixel in between
+            const float distance = toInside[i] == 0.0f ? std::sqrt(toOutside[i]) - 0.5f : 0.5f - std::sqrt(toInside[i]);
+            const float value = std::max(0.0f, std::min(0.5f + distance * scale, 1.0f)) * maxValue + 0.5f;
+
+            if(sixteenBit)
+                ((quint16*)line)[x] = (quint16)value;
+            else
+                line[x] = (uchar)value;
+        }
+    }
+
+    return result;
+}
+
+std::vector<int> DistanceFieldGenerator::calculateNearestInside(const QImage &mask, bool tileable) {
+    const int width = mask.width();
+    const int height = mask.height();
+    const size_t size = (size_t)width * height;
+    std::vector<int> nearest(size, -1);
+    if(size == 0)
+        return nearest;
+
+    const QImage argb = mask.convertToFormat(QImage::Format_ARGB32);
+    const int columnBlocks = (width + DISTANCEFIELD_COLUMN_BLOCK - 1) / DISTANCEFIELD_COLUMN_BLOCK;
+    if(progress)
+        progress->addWork(columnBlocks + height);
+
+    std::vector< float, PoolAllocator<float> > toInside(size);
+
+    #pragma omp parallel for  // OpenMP
+    for(int y = 0; y < height; y++) {
+        const QRgb *line = (const QRgb*)argb.constScanLine(y);
+        for(int x = 0; x < width; x++)
+            toInside[(size_t)y * width + x] = qAlpha(line[x]) >= 128 ? 0.0f : DISTANCEFIELD_INFINITY;
+    }
+
+    transform(toInside, width, height, tileable, &nearest);
+    return nearest;
+}
+
+//squared distance transform of the field in place: 0 at the sites, DISTANCEFIELD_INFINITY elsewhere.
+//nearest: optional, set to the index of the nearest site of every pixel (-1 without sites)
+void DistanceFieldGenerator::transform(std::vector< float, PoolAllocator<float> > &field, int width, int height, bool tileable,
+                                       std::vector<int> *nearest) const {
+    float *data = field.data();
+    //rows of the nearest sites in the columns, they become the whole index in the row pass
+    std::vector<int> columnSites;
+    if(nearest)
+        columnSites.resize((size_t)width * height);
+
+    #pragma omp parallel  // OpenMP
+    {
+        std::vector<double> g;
+        std::vector<int> v;
+        std::vector<double> z;
+        std::vector<float> columns((size_t)DISTANCEFIELD_COLUMN_BLOCK * height);
+        std::vector<float> transformed(height);
+        std::vector<int> sites(nearest ? DISTANCEFIELD_COLUMN_BLOCK * height : 0);
+
+        #pragma omp for  // OpenMP
+        for(int block = 0; block < (width + DISTANCEFIELD_COLUMN_BLOCK - 1) / DISTANCEFIELD_COLUMN_BLOCK; block++) {
+            if(progress && progress->isCanceled())
+                continue;
+
+            const int x0 = block * DISTANCEFIELD_COLUMN_BLOCK;
+            const int count = std::min(DISTANCEFIELD_COLUMN_BLOCK, width - x0);
+
+            for(int y = 0; y < height; y++) {
+                for(int i = 0; i < count; i++)
+                    columns[(size_t)i * height + y] = data[(size_t)y * width + x0 + i];
+            }
+
+            for(int i = 0; i < count; i++) {
+                transformLine(&columns[(size_t)i * height], transformed.data(), height, tileable,
+                              nearest ? &sites[(size_t)i * height] : 0, g, v, z);
+                std::copy(transformed.begin(), transformed.end(), columns.begin() + (size_t)i * height);
+            }
+
+            for(int y = 0; y < height; y++) {
+                for(int i = 0; i < count; i++)
+                    data[(size_t)y * width + x0 + i] = columns[(size_t)i * height + y];
+            }
+
+            if(nearest) {
+                for(int y = 0; y < height; y++) {
+                    for(int i = 0; i < count; i++)
+                        columnSites[(size_t)y * width + x0 + i] = sites[(size_t)i * height + y];
+                }
+            }
+
+            if(progress)
+                progress->advance();
+        }
+
+        std::vector<float> row(width);
+        std::vector<int> rowSites(nearest ? width : 0);
+
+        #pragma omp for  // OpenMP
+        for(int y = 0; y < height; y++) {
+            if(progress && progress->isCanceled())
+                continue;
+
+            float *line = data + (size_t)y * width;
+            std::copy(line, line + width, row.begin());
+            transformLine(row.data(), line, width, tileable, nearest ? rowSites.data() : 0, g, v, z);
+
+            if(nearest) {
+                const int *siteRows = &columnSites[(size_t)y * width];
+                int *result = &(*nearest)[(size_t)y * width];
+                for(int x = 0; x < width; x++) {
+                    const int siteX = rowSites[x];
+                    result[x] = siteX < 0 ? -1 : siteRows[siteX] * width + siteX;
+                }
+            }
+
+            if(progress)
+                progress->advance();
+        }
+    }
+}
+
+//1D squared distance transform d(p) = min over q of (p - q)^2 + f(q) as the lower envelope of the parabolas.
+//tileable: the line is repeated on both sides, so sites behind the borders are found too.
+//site: optional, set to the position of the nearest site (-1 without sites).
+//g, v, z: buffers of the caller reused for every line. The intersections are calculated in double,
+//q * q is not exact in float beyond 4096 (the tileable lines are 3 times as long)
+void DistanceFieldGenerator::transformLine(const float *f, float *d, int n, bool tileable, int *site,
+                                           std::vector<double> &g, std::vector<int> &v, std::vector<double> &z) {
+    //lines without sites stay infinitely far away
+    bool anySite = false;
+    for(int i = 0; i < n; i++)
+        anySite |= f[i] < DISTANCEFIELD_INFINITY;
+
+    if(!anySite) {
+        std::copy(f, f + n, d);
+        if(site)
+            std::fill(site, site + n, -1);
+        return;
+    }
+
+    const int offset = tileable ? n : 0;
+    const int length = tileable ? 3 * n : n;
+    g.resize(length);
+    v.resize(length);
+    z.resize(length + 1);
+
+    for(int i = 0; i < length; i++)
+        g[i] = f[i % n];
+
+    //parabolas of the lower envelope (v) and the boundaries between them (z)
+    int k = 0;
+    v[0] = 0;
+    z[0] = -DISTANCEFIELD_INFINITY;
+    z[1] = DISTANCEFIELD_INFINITY;
+
+    for(int q = 1; q < length; q++) {
+        //intersection with the last parabola, the ones hidden by the new parabola are removed
+        //(the first boundary is never passed: the infinite heights stay above -DISTANCEFIELD_INFINITY / 2)
+        double s = ((g[q] - g[v[k]]) + (double)(q - v[k]) * (q + v[k])) / (2.0 * (q - v[k]));
+        while(s <= z[k]) {
+            k--;
+            s = ((g[q] - g[v[k]]) + (double)(q - v[k]) * (q + v[k])) / (2.0 * (q - v[k]));
+        }
+
+        k++;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = DISTANCEFIELD_INFINITY;
+    }
+
+    k = 0;
+    for(int q = offset; q < offset + n; q++) {
+        while(z[k + 1] < q)
+            k++;
+        const long long distance = q - v[k];
+        d[q - offset] = (float)(distance * distance + g[v[k]]);
+        if(site)
+            site[q - offset] = v[k] % n;
+    }
+}
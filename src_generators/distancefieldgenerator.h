@@ -0,0 +1,54 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#ifndef DISTANCEFIELDGENERATOR_H
+#define DISTANCEFIELDGENERATOR_H
+
+#include <QImage>
+#include <vector>
+#include "generatorprogress.h"
+#include "bufferpool.h"
+
+// Signed distance fields of the alpha mask (alpha >= 50% is inside) for decals and cutouts.
+// The exact euclidean distance transform of Felzenszwalb and Huttenlocher: the squared
+// distances are the lower envelope of parabolas, calculated in linear time per line,
+// first for the columns and then for the rows of the result.
+class DistanceFieldGenerator
+{
+public:
+    DistanceFieldGenerator();
+    //0.5 on the edge, 1 at spread pixels inside and 0 at spread pixels outside of the mask.
+    //sixteenBit: Format_Grayscale16 instead of Format_Grayscale8
+    QImage calculateDistanceField(const QImage &input, double spread, bool tileable, bool sixteenBit);
+    //for every pixel the index (y * width + x) of the nearest pixel inside the mask, -1 if there is none
+    std::vector<int> calculateNearestInside(const QImage &mask, bool tileable);
+    void setProgress(GeneratorProgress *progress);
+
+private:
+    GeneratorProgress *progress;
+
+    void transform(std::vector< float, PoolAllocator<float> > &field, int width, int height, bool tileable,
+                   std::vector<int> *nearest = 0) const;
+    static void transformLine(const float *f, float *d, int n, bool tileable, int *site,
+                              std::vector<double> &g, std::vector<int> &v, std::vector<double> &z);
+};
+
+#endif // DISTANCEFIELDGENERATOR_H
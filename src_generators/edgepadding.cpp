@@ -0,0 +1,104 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#include "edgepadding.h"
+#include "distancefieldgenerator.h"
+#include <cstdlib>
+#include <algorithm>
+#include <cstring>
+
+EdgePadding::EdgePadding()
+    : progress(0)
+{
+}
+
+//optional, passed on to the distance transform
+void EdgePadding::setProgress(GeneratorProgress *progress) {
+    this->progress = progress;
+}
+
+QSize EdgePadding::getSize() const {
+    return size;
+}
+
+void EdgePadding::calculate(const QImage &mask, int width, bool tileable) {
+    DistanceFieldGenerator distanceFieldGenerator;
+    distanceFieldGenerator.setProgress(progress);
+    sources = distanceFieldGenerator.calculateNearestInside(mask, tileable);
+    size = mask.size();
+
+    //the distances are measured to the found pixel in integers, the float squared
+    //distances of the transform are not exact beyond 4096 pixels
+    const long long maxSquaredDistance = (long long)width * width;
+    const int maskWidth = size.width();
+    const int maskHeight = size.height();
+    const int count = (int)sources.size();
+
+    #pragma omp parallel for  // OpenMP
+    for(int i = 0; i < count; i++) {
+        //pixels inside copy themselves
+        if(sources[i] == i) {
+            sources[i] = -1;
+            continue;
+        }
+
+        if(width == 0 || sources[i] < 0)
+            continue;
+
+        long long dx = std::abs(sources[i] % maskWidth - i % maskWidth);
+        long long dy = std::abs(sources[i] / maskWidth - i / maskWidth);
+        if(tileable) {
+            dx = std::min(dx, maskWidth - dx);
+            dy = std::min(dy, maskHeight - dy);
+        }
+
+        if(dx * dx + dy * dy > maxSquaredDistance)
+            sources[i] = -1;
+    }
+}
+
+QImage EdgePadding::apply(const QImage &map) const {
+    if(map.isNull() || map.size() != size)
+        return map;
+
+    //whole bytes per pixel are copied, packed formats are unpacked first
+    QImage result = map.depth() < 8 ? map.convertToFormat(QImage::Format_ARGB32) : map.copy();
+    const int bytesPerPixel = result.depth() / 8;
+    const int width = result.width();
+    const int bytesPerLine = result.bytesPerLine();
+    uchar *bits = result.bits();
+
+    #pragma omp parallel for  // OpenMP
+    for(int y = 0; y < result.height(); y++) {
+        uchar *line = bits + (size_t)y * bytesPerLine;
+
+        for(int x = 0; x < width; x++) {
+            const int source = sources[(size_t)y * width + x];
+            if(source < 0)
+                continue;
+
+            const uchar *sourcePixel = bits + (size_t)(source / width) * bytesPerLine + (size_t)(source % width) * bytesPerPixel;
+            std::memcpy(line + (size_t)x * bytesPerPixel, sourcePixel, bytesPerPixel);
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,54 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#ifndef EDGEPADDING_H
+#define EDGEPADDING_H
+
+#include <QImage>
+#include <vector>
+#include "generatorprogress.h"
+
+// Dilates maps past the borders of the UV islands, so mipmaps of atlases do not mix
+// the background into the islands. The nearest pixel inside the mask is found once
+// with a distance transform (linear time, no matter how wide the padding is),
+// then every map of the mask's size is padded by copying from it.
+class EdgePadding
+{
+public:
+    EdgePadding();
+    //mask: pixels with alpha >= 50% keep their value.
+    //width: pixels farther from the mask stay unchanged, 0 pads the whole image
+    void calculate(const QImage &mask, int width, bool tileable);
+    //the map with its pixels outside of the mask copied from the nearest pixel inside.
+    //Maps of another size than the mask are returned unchanged
+    QImage apply(const QImage &map) const;
+    QSize getSize() const;
+    void setProgress(GeneratorProgress *progress);
+
+private:
+    GeneratorProgress *progress;
+
+    QSize size;
+    //the pixel each pixel is copied from, -1 for the unchanged ones
+    std::vector<int> sources;
+};
+
+#endif // EDGEPADDING_H
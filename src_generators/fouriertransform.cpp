@@ -0,0 +1,250 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#include "fouriertransform.h"
+#include <cmath>
+
+FourierTransform::FourierTransform(int width, int height)
+    : width(width), height(height), rowPlan(width), columnPlan(height)
+{
+}
+
+int FourierTransform::getSpectrumWidth() const {
+    return width / 2 + 1;
+}
+
+// Two real rows are transformed at once as real and imaginary part of one complex row,
+// their spectra are separated using the symmetry of real signals. Then the columns are transformed.
+FourierTransform::Spectrum FourierTransform::forward(const double *image) const {
+    const int spectrumWidth = getSpectrumWidth();
+    Spectrum spectrum((size_t)spectrumWidth * height);
+    const int rowPairs = (height + 1) / 2;
+
+    #pragma omp parallel  // OpenMP
+    {
+        std::vector<Complex> row(width);
+        std::vector<Complex> scratch(std::max(rowPlan.getScratchSize(), columnPlan.getScratchSize()));
+
+        #pragma omp for
+        for(int pair = 0; pair < rowPairs; pair++) {
+            const int y0 = 2 * pair;
+            const int y1 = y0 + 1;
+            const double *row0 = &image[(size_t)y0 * width];
+            const double *row1 = (y1 < height) ? &image[(size_t)y1 * width] : 0;
+
+            for(int x = 0; x < width; x++) {
+                row[x] = Complex((float)row0[x], row1 ? (float)row1[x] : 0.0f);
+            }
+
+            rowPlan.transform(&row[0], false, &scratch[0]);
+
+            for(int k = 0; k < spectrumWidth; k++) {
+                const Complex z = row[k];
+                const Complex zMirrored = std::conj(row[(width - k) % width]);
+                spectrum[(size_t)y0 * spectrumWidth + k] = 0.5f * (z + zMirrored);
+                if(row1)
+                    spectrum[(size_t)y1 * spectrumWidth + k] = Complex(0.0f, -0.5f) * (z - zMirrored);
+            }
+        }
+
+        std::vector<Complex> column(height);
+
+        #pragma omp for
+        for(int k = 0; k < spectrumWidth; k++) {
+            for(int y = 0; y < height; y++) {
+                column[y] = spectrum[(size_t)y * spectrumWidth + k];
+            }
+
+            columnPlan.transform(&column[0], false, &scratch[0]);
+
+            for(int y = 0; y < height; y++) {
+                spectrum[(size_t)y * spectrumWidth + k] = column[y];
+            }
+        }
+    }
+
+    return spectrum;
+}
+
+void FourierTransform::inverse(const Spectrum &spectrum, double *image) const {
+    const int spectrumWidth = getSpectrumWidth();
+    Spectrum columns(spectrum);
+    const int rowPairs = (height + 1) / 2;
+    const double normalization = 1.0 / ((double)width * height);
+
+    #pragma omp parallel  // OpenMP
+    {
+        std::vector<Complex> column(height);
+        std::vector<Complex> scratch(std::max(rowPlan.getScratchSize(), columnPlan.getScratchSize()));
+
+        #pragma omp for
+        for(int k = 0; k < spectrumWidth; k++) {
+            for(int y = 0; y < height; y++) {
+                column[y] = columns[(size_t)y * spectrumWidth + k];
+            }
+
+            columnPlan.transform(&column[0], true, &scratch[0]);
+
+            for(int y = 0; y < height; y++) {
+                columns[(size_t)y * spectrumWidth + k] = column[y];
+            }
+        }
+
+        std::vector<Complex> row(width);
+
+        //the rows are real again, so two of them are combined into one complex row
+        #pragma omp for
+        for(int pair = 0; pair < rowPairs; pair++) {
+            const int y0 = 2 * pair;
+            const int y1 = y0 + 1;
+            const Complex *spectrum0 = &columns[(size_t)y0 * spectrumWidth];
+            const Complex *spectrum1 = (y1 < height) ? &columns[(size_t)y1 * spectrumWidth] : 0;
+
+            for(int k = 0; k < width; k++) {
+                //the missing half of a row spectrum is the conjugate of the stored half
+                const Complex value0 = (k < spectrumWidth) ? spectrum0[k] : std::conj(spectrum0[width - k]);
+                Complex value1(0.0f, 0.0f);
+                if(spectrum1)
+                    value1 = (k < spectrumWidth) ? spectrum1[k] : std::conj(spectrum1[width - k]);
+
+                row[k] = value0 + Complex(0.0f, 1.0f) * value1;
+            }
+
+            rowPlan.transform(&row[0], true, &scratch[0]);
+
+            for(int x = 0; x < width; x++) {
+                image[(size_t)y0 * width + x] = row[x].real() * normalization;
+                if(spectrum1)
+                    image[(size_t)y1 * width + x] = row[x].imag() * normalization;
+            }
+        }
+    }
+}
+
+FourierTransform::Plan::Plan(int size)
+    : size(size)
+{
+    powerOfTwo = size > 0 && (size & (size - 1)) == 0;
+
+    //Bluestein's algorithm turns the transform into a convolution of size >= 2 * size - 1
+    fftSize = 1;
+    while(fftSize < (powerOfTwo ? size : 2 * size - 1)) {
+        fftSize *= 2;
+    }
+
+    int bits = 0;
+    while((1 << bits) < fftSize) {
+        bits++;
+    }
+
+    bitReversal.resize(fftSize);
+    for(int i = 0; i < fftSize; i++) {
+        int reversed = 0;
+        for(int b = 0; b < bits; b++) {
+            if(i & (1 << b))
+                reversed |= 1 << (bits - 1 - b);
+        }
+        bitReversal[i] = reversed;
+    }
+
+    twiddles.resize(fftSize / 2);
+    for(int i = 0; i < fftSize / 2; i++) {
+        const double angle = -2.0 * M_PI * i / fftSize;
+        twiddles[i] = Complex((float)cos(angle), (float)sin(angle));
+    }
+
+    if(!powerOfTwo) {
+        chirp.resize(size);
+        for(int k = 0; k < size; k++) {
+            //k^2 mod 2 * size keeps the angle small and exact
+            const long long kSquared = ((long long)k * k) % (2LL * size);
+            const double angle = -M_PI * kSquared / size;
+            chirp[k] = Complex((float)cos(angle), (float)sin(angle));
+        }
+
+        chirpSpectrum.assign(fftSize, Complex(0.0f, 0.0f));
+        chirpSpectrum[0] = std::conj(chirp[0]);
+        for(int k = 1; k < size; k++) {
+            chirpSpectrum[k] = std::conj(chirp[k]);
+            chirpSpectrum[fftSize - k] = std::conj(chirp[k]);
+        }
+        transformPowerOfTwo(&chirpSpectrum[0], false);
+    }
+}
+
+int FourierTransform::Plan::getScratchSize() const {
+    return powerOfTwo ? 1 : fftSize;
+}
+
+void FourierTransform::Plan::transform(Complex *data, bool inverse, Complex *scratch) const {
+    if(powerOfTwo) {
+        transformPowerOfTwo(data, inverse);
+        return;
+    }
+
+    //the inverse transform is the conjugate of the forward transform of the conjugate
+    for(int k = 0; k < size; k++) {
+        const Complex value = inverse ? std::conj(data[k]) : data[k];
+        scratch[k] = value * chirp[k];
+    }
+    for(int k = size; k < fftSize; k++) {
+        scratch[k] = Complex(0.0f, 0.0f);
+    }
+
+    //convolution with the conjugate chirp
+    transformPowerOfTwo(scratch, false);
+    for(int k = 0; k < fftSize; k++) {
+        scratch[k] *= chirpSpectrum[k];
+    }
+    transformPowerOfTwo(scratch, true);
+
+    const float normalization = 1.0f / fftSize;
+    for(int k = 0; k < size; k++) {
+        const Complex value = scratch[k] * chirp[k] * normalization;
+        data[k] = inverse ? std::conj(value) : value;
+    }
+}
+
+//iterative radix-2 decimation in time, not normalized
+void FourierTransform::Plan::transformPowerOfTwo(Complex *data, bool inverse) const {
+    for(int i = 0; i < fftSize; i++) {
+        if(i < bitReversal[i])
+            std::swap(data[i], data[bitReversal[i]]);
+    }
+
+    for(int length = 2; length <= fftSize; length *= 2) {
+        const int half = length / 2;
+        const int twiddleStep = fftSize / length;
+
+        for(int start = 0; start < fftSize; start += length) {
+            for(int j = 0; j < half; j++) {
+                Complex twiddle = twiddles[j * twiddleStep];
+                if(inverse)
+                    twiddle = std::conj(twiddle);
+
+                const Complex even = data[start + j];
+                const Complex odd = data[start + j + half] * twiddle;
+                data[start + j] = even + odd;
+                data[start + j + half] = even - odd;
+            }
+        }
+    }
+}
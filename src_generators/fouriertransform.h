@@ -0,0 +1,76 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#ifndef FOURIERTRANSFORM_H
+#define FOURIERTRANSFORM_H
+
+#include <complex>
+#include <vector>
+#include "bufferpool.h"
+
+// 2D fast fourier transform of real images, for filtering tileable (periodic) textures
+// as multiplications in the frequency domain.
+// Sizes that are powers of two use an iterative radix-2 transform, other sizes are
+// computed with Bluestein's algorithm on top of it. Rows and columns are transformed in parallel.
+// The spectrum of a width x height image has getSpectrumWidth() x height values,
+// the other half is the complex conjugate and is not stored.
+class FourierTransform
+{
+public:
+    typedef std::complex<float> Complex;
+    typedef std::vector< Complex, PoolAllocator<Complex> > Spectrum;
+
+    FourierTransform(int width, int height);
+    int getSpectrumWidth() const;
+    //row after row
+    Spectrum forward(const double *image) const;
+    //the result is normalized, inverse(forward(image)) gives the image again
+    void inverse(const Spectrum &spectrum, double *image) const;
+
+private:
+    // one dimensional transform of a fixed size
+    class Plan {
+    public:
+        explicit Plan(int size);
+        //size of the scratch buffer transform() needs
+        int getScratchSize() const;
+        void transform(Complex *data, bool inverse, Complex *scratch) const;
+
+    private:
+        int size;
+        bool powerOfTwo;
+        //radix-2 transform, for Bluestein its size is the padded convolution size
+        int fftSize;
+        std::vector<int> bitReversal;
+        std::vector<Complex> twiddles;
+        //Bluestein: chirp exp(-i pi k^2 / size) and the spectrum of its conjugate (the convolution kernel)
+        std::vector<Complex> chirp;
+        std::vector<Complex> chirpSpectrum;
+
+        void transformPowerOfTwo(Complex *data, bool inverse) const;
+    };
+
+    int width, height;
+    Plan rowPlan;
+    Plan columnPlan;
+};
+
+#endif // FOURIERTRANSFORM_H
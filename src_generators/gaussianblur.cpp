@@ -20,17 +20,31 @@
  ********************************************************************************/
 
 #include "gaussianblur.h"
+#include "fouriertransform.h"
 #include <math.h>
 #include <iostream>
 
+//from this radius on tileable images are blurred in the frequency domain,
+//the cost of the box blurs grows with the radius while the fourier transform's does not
+static const double FOURIER_BLUR_MIN_RADIUS = 16.0;
+
 GaussianBlur::GaussianBlur()
+    : progress(0)
 {
 }
 
+//optional, rows are reported to it and it can cancel the calculation
+void GaussianBlur::setProgress(GeneratorProgress *progress) {
+    this->progress = progress;
+}
+
 IntensityMap GaussianBlur::calculate(IntensityMap &input, double radius, bool tileable) {
     IntensityMap result = IntensityMap(input.getWidth(), input.getHeight());
 
-    gaussBlur(input, result, radius, tileable);
+    if(tileable && radius >= FOURIER_BLUR_MIN_RADIUS)
+        fourierBlur(input, result, radius);
+    else
+        gaussBlur(input, result, radius, tileable);
 
     return result;
 }
@@ -41,11 +55,60 @@ IntensityMap GaussianBlur::calculate(IntensityMap &input, double radius, bool ti
 void GaussianBlur::gaussBlur(IntensityMap &input, IntensityMap &result, double radius, bool tileable) {
     std::vector<double> boxes = boxesForGauss(radius, 3);
 
+    //three box blurs with a horizontal and a vertical pass each
+    if(progress)
+        progress->addWork(6 * input.getHeight());
+
     boxBlur(input, result, ((boxes.at(0) - 1) / 2), tileable);
     boxBlur(result, input, ((boxes.at(1) - 1) / 2), tileable);
     boxBlur(input, result, ((boxes.at(2) - 1) / 2), tileable);
 }
 
+// Exact (periodic) gaussian: the spectrum is multiplied with the transfer function
+// exp(-2 pi^2 sigma^2 f^2), f in cycles per pixel
+void GaussianBlur::fourierBlur(IntensityMap &input, IntensityMap &result, double radius) {
+    const int width = input.getWidth();
+    const int height = input.getHeight();
+
+    //forward transform, filter, inverse transform
+    if(progress)
+        progress->addWork(3);
+
+    FourierTransform fourierTransform(width, height);
+    FourierTransform::Spectrum spectrum = fourierTransform.forward(input.data());
+    const int spectrumWidth = fourierTransform.getSpectrumWidth();
+
+    if(progress) {
+        progress->advance();
+        if(progress->isCanceled())
+            return;
+    }
+
+    const double factor = -2.0 * M_PI * M_PI * radius * radius;
+
+    #pragma omp parallel for  // OpenMP
+    for(int l = 0; l < height; l++) {
+        //frequencies above the nyquist frequency are the negative ones
+        const double fy = (double)(l <= height / 2 ? l : l - height) / height;
+
+        for(int k = 0; k < spectrumWidth; k++) {
+            const double fx = (double)k / width;
+            spectrum[(size_t)l * spectrumWidth + k] *= (float)exp(factor * (fx * fx + fy * fy));
+        }
+    }
+
+    if(progress) {
+        progress->advance();
+        if(progress->isCanceled())
+            return;
+    }
+
+    fourierTransform.inverse(spectrum, result.data());
+
+    if(progress)
+        progress->advance();
+}
+
 std::vector<double> GaussianBlur::boxesForGauss(double sigma, int n) {
     double wIdeal = sqrt((12 * sigma * sigma / n) + 1);
     int wl = floor(wIdeal);
@@ -82,6 +145,9 @@ void GaussianBlur::boxBlurH(IntensityMap &input, IntensityMap &result, double ra
 
     #pragma omp parallel for  // OpenMP
     for(int i = 0; i < height; i++) {
+        if(progress && progress->isCanceled())
+            continue;
+
         for(int j = 0; j < width; j++) {
             double val = 0.0;
 
@@ -92,6 +158,9 @@ void GaussianBlur::boxBlurH(IntensityMap &input, IntensityMap &result, double ra
 
             result.setValue(j, i, val / (radius + radius + 1));
         }
+
+        if(progress)
+            progress->advance();
     }
 }
 
@@ -101,6 +170,9 @@ void GaussianBlur::boxBlurT(IntensityMap &input, IntensityMap &result, double ra
 
     #pragma omp parallel for  // OpenMP
     for(int i = 0; i < height; i++) {
+        if(progress && progress->isCanceled())
+            continue;
+
         for(int j = 0; j < width; j++) {
             double val = 0.0;
 
@@ -111,6 +183,9 @@ void GaussianBlur::boxBlurT(IntensityMap &input, IntensityMap &result, double ra
 
             result.setValue(j, i, val / (radius + radius + 1));
         }
+
+        if(progress)
+            progress->advance();
     }
 }
 
@@ -23,16 +23,21 @@
 #define GAUSSIANBLUR_H
 
 #include "intensitymap.h"
+#include "generatorprogress.h"
 
 class GaussianBlur
 {
 public:
     GaussianBlur();
     IntensityMap calculate(IntensityMap& input, double radius, bool tileable);
+    void setProgress(GeneratorProgress *progress);
 
 private:
+    GeneratorProgress *progress;
+
     std::vector<double> boxesForGauss(double sigma, int n);
     void gaussBlur(IntensityMap &input, IntensityMap &result, double radius, bool tileable);
+    void fourierBlur(IntensityMap &input, IntensityMap &result, double radius);
     void boxBlur(IntensityMap &input, IntensityMap &result, double radius, bool tileable);
     void boxBlurH(IntensityMap &input, IntensityMap &result, double radius, bool tileable);
     void boxBlurT(IntensityMap &input, IntensityMap &result, double radius, bool tileable);
@@ -0,0 +1,53 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#include "generatorprogress.h"
+#include <algorithm>
+
+GeneratorProgress::GeneratorProgress()
+    : total(0), done(0), canceled(false)
+{
+}
+
+//call before starting a new generator, not while one is running
+void GeneratorProgress::reset() {
+    total.store(0, std::memory_order_relaxed);
+    done.store(0, std::memory_order_relaxed);
+    canceled.store(false, std::memory_order_relaxed);
+}
+
+void GeneratorProgress::addWork(long long units) {
+    total.fetch_add(units, std::memory_order_relaxed);
+}
+
+//0..1, work announced later (e.g. by a second pass) can make it go back a little
+double GeneratorProgress::getProgress() const {
+    const long long totalUnits = total.load(std::memory_order_relaxed);
+    if(totalUnits <= 0)
+        return 0.0;
+
+    const long long doneUnits = done.load(std::memory_order_relaxed);
+    return std::min((double)doneUnits / totalUnits, 1.0);
+}
+
+void GeneratorProgress::cancel() {
+    canceled.store(true, std::memory_order_relaxed);
+}
@@ -0,0 +1,54 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#ifndef GENERATORPROGRESS_H
+#define GENERATORPROGRESS_H
+
+#include <atomic>
+
+// Shared between a running generator and the thread that polls it.
+// The generators announce their work in units (usually rows) and count the finished ones,
+// all with relaxed atomics so the hot loops take no locks and emit no signals.
+// A canceled generator stops at the next row and returns an incomplete result.
+class GeneratorProgress
+{
+public:
+    GeneratorProgress();
+    void reset();
+    void addWork(long long units);
+    double getProgress() const;
+    void cancel();
+
+    void advance(long long units = 1) {
+        done.fetch_add(units, std::memory_order_relaxed);
+    }
+
+    bool isCanceled() const {
+        return canceled.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<long long> total;
+    std::atomic<long long> done;
+    std::atomic<bool> canceled;
+};
+
+#endif // GENERATORPROGRESS_H
@@ -0,0 +1,235 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#include "guidedfilter.h"
+#include <cmath>
+
+//columns per thread when the summed area table is accumulated down the columns
+static const int GUIDEDFILTER_COLUMN_BLOCK = 64;
+
+GuidedFilter::GuidedFilter()
+    : progress(0)
+{
+}
+
+//optional, rows are reported to it and it can cancel the calculation
+void GuidedFilter::setProgress(GeneratorProgress *progress) {
+    this->progress = progress;
+}
+
+void GuidedFilter::apply(IntensityMap &map, int radius, double epsilon, bool tileable) const {
+    const int width = map.getWidth();
+    const int height = map.getHeight();
+    if(width == 0 || height == 0 || radius <= 0)
+        return;
+
+    //a wrapped window must not overlap itself
+    if(tileable)
+        radius = std::min(radius, (std::min(width, height) - 1) / 2);
+    if(radius <= 0)
+        return;
+
+    if(progress)
+        progress->addWork(2 * height);
+
+    //summed area tables with an extra zero row and column: of the intensity and of its square,
+    //later of the coefficients a and b of the local linear model q = a * I + b
+    const size_t tableSize = (size_t)(width + 1) * (height + 1);
+    Table sumI(tableSize, 0.0);
+    Table sumII(tableSize, 0.0);
+    double *data = map.data();
+
+    #pragma omp parallel for  // OpenMP
+    for(int y = 0; y < height; y++) {
+        const double *row = data + (size_t)y * width;
+        double *rowI = &sumI[(size_t)(y + 1) * (width + 1) + 1];
+        double *rowII = &sumII[(size_t)(y + 1) * (width + 1) + 1];
+
+        for(int x = 0; x < width; x++) {
+            rowI[x] = row[x];
+            rowII[x] = row[x] * row[x];
+        }
+    }
+
+    buildTable(sumI, width, height);
+    buildTable(sumII, width, height);
+
+    //coefficients of the local linear model of every window, float planes so the filter needs
+    //3 times the memory of the map on top of it instead of 4 times
+    Plane coefficientA((size_t)width * height);
+    Plane coefficientB((size_t)width * height);
+
+    #pragma omp parallel for  // OpenMP
+    for(int y = 0; y < height; y++) {
+        if(progress && progress->isCanceled())
+            continue;
+
+        float *rowA = &coefficientA[(size_t)y * width];
+        float *rowB = &coefficientB[(size_t)y * width];
+
+        for(int x = 0; x < width; x++) {
+            const double mean = boxMean(sumI, width, height, x, y, radius, tileable);
+            const double variance = std::max(boxMean(sumII, width, height, x, y, radius, tileable) - mean * mean, 0.0);
+            const double a = variance / (variance + epsilon);
+
+            rowA[x] = a;
+            rowB[x] = (1.0 - a) * mean;
+        }
+
+        if(progress)
+            progress->advance();
+    }
+
+    if(progress && progress->isCanceled())
+        return;
+
+    //the tables are reused for the coefficients
+    Table &sumA = sumI;
+    Table &sumB = sumII;
+
+    #pragma omp parallel for  // OpenMP
+    for(int y = 0; y < height; y++) {
+        const float *rowA = &coefficientA[(size_t)y * width];
+        const float *rowB = &coefficientB[(size_t)y * width];
+        double *rowSumA = &sumA[(size_t)(y + 1) * (width + 1) + 1];
+        double *rowSumB = &sumB[(size_t)(y + 1) * (width + 1) + 1];
+
+        for(int x = 0; x < width; x++) {
+            rowSumA[x] = rowA[x];
+            rowSumB[x] = rowB[x];
+        }
+    }
+
+    buildTable(sumA, width, height);
+    buildTable(sumB, width, height);
+
+    //every pixel is in several windows, their models are averaged
+    #pragma omp parallel for  // OpenMP
+    for(int y = 0; y < height; y++) {
+        if(progress && progress->isCanceled())
+            continue;
+
+        double *row = data + (size_t)y * width;
+
+        for(int x = 0; x < width; x++) {
+            row[x] = boxMean(sumA, width, height, x, y, radius, tileable) * row[x]
+                     + boxMean(sumB, width, height, x, y, radius, tileable);
+        }
+
+        if(progress)
+            progress->advance();
+    }
+}
+
+//turns the values (stored from row 1 and column 1 on) into their summed area table
+void GuidedFilter::buildTable(Table &table, int width, int height) const {
+    const size_t stride = width + 1;
+
+    //prefix sums along the rows
+    #pragma omp parallel for  // OpenMP
+    for(int y = 1; y <= height; y++) {
+        double *row = &table[(size_t)y * stride];
+        for(int x = 1; x <= width; x++) {
+            row[x] += row[x - 1];
+        }
+    }
+
+    //then down the columns, every thread adds whole rows of a block of columns
+    const int blocks = (width + GUIDEDFILTER_COLUMN_BLOCK - 1) / GUIDEDFILTER_COLUMN_BLOCK;
+
+    #pragma omp parallel for  // OpenMP
+    for(int block = 0; block < blocks; block++) {
+        const int firstColumn = 1 + block * GUIDEDFILTER_COLUMN_BLOCK;
+        const int lastColumn = std::min(firstColumn + GUIDEDFILTER_COLUMN_BLOCK, width + 1);
+
+        for(int y = 1; y <= height; y++) {
+            double *row = &table[(size_t)y * stride];
+            const double *previous = row - stride;
+
+            #pragma omp simd
+            for(int x = firstColumn; x < lastColumn; x++) {
+                row[x] += previous[x];
+            }
+        }
+    }
+}
+
+//sum of the pixels x0 <= x < x1, y0 <= y < y1
+double GuidedFilter::boxSum(const Table &table, int width, int x0, int y0, int x1, int y1) const {
+    const size_t stride = width + 1;
+    return table[(size_t)y1 * stride + x1] - table[(size_t)y0 * stride + x1]
+         - table[(size_t)y1 * stride + x0] + table[(size_t)y0 * stride + x0];
+}
+
+//mean of the window with the given radius around a pixel. Windows crossing the borders
+//wrap around for tileable maps (up to four rectangles), otherwise they are cut off
+double GuidedFilter::boxMean(const Table &table, int width, int height, int x, int y, int radius, bool tileable) const {
+    int x0 = x - radius;
+    int x1 = x + radius + 1;
+    int y0 = y - radius;
+    int y1 = y + radius + 1;
+
+    if(!tileable) {
+        x0 = std::max(x0, 0);
+        y0 = std::max(y0, 0);
+        x1 = std::min(x1, width);
+        y1 = std::min(y1, height);
+        return boxSum(table, width, x0, y0, x1, y1) / ((double)(x1 - x0) * (y1 - y0));
+    }
+
+    //split the window at the borders into ranges inside the map
+    int rangesX[2][2], rangesY[2][2];
+    int countX = 0, countY = 0;
+
+    if(x0 < 0) {
+        rangesX[countX][0] = x0 + width; rangesX[countX][1] = width; countX++;
+        rangesX[countX][0] = 0; rangesX[countX][1] = x1; countX++;
+    }
+    else if(x1 > width) {
+        rangesX[countX][0] = x0; rangesX[countX][1] = width; countX++;
+        rangesX[countX][0] = 0; rangesX[countX][1] = x1 - width; countX++;
+    }
+    else {
+        rangesX[countX][0] = x0; rangesX[countX][1] = x1; countX++;
+    }
+
+    if(y0 < 0) {
+        rangesY[countY][0] = y0 + height; rangesY[countY][1] = height; countY++;
+        rangesY[countY][0] = 0; rangesY[countY][1] = y1; countY++;
+    }
+    else if(y1 > height) {
+        rangesY[countY][0] = y0; rangesY[countY][1] = height; countY++;
+        rangesY[countY][0] = 0; rangesY[countY][1] = y1 - height; countY++;
+    }
+    else {
+        rangesY[countY][0] = y0; rangesY[countY][1] = y1; countY++;
+    }
+
+    double sum = 0.0;
+    for(int i = 0; i < countY; i++) {
+        for(int k = 0; k < countX; k++) {
+            sum += boxSum(table, width, rangesX[k][0], rangesY[i][0], rangesX[k][1], rangesY[i][1]);
+        }
+    }
+
+    const double size = 2 * radius + 1;
+    return sum / (size * size);
+}
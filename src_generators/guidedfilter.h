@@ -0,0 +1,51 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#ifndef GUIDEDFILTER_H
+#define GUIDEDFILTER_H
+
+#include "intensitymap.h"
+#include "generatorprogress.h"
+
+// Edge preserving smoothing (guided filter, with the map as its own guide). In flat areas
+// the result is the local mean, at edges (local variance much larger than epsilon) the input is kept.
+// All means are box filters read from summed area tables, so the cost does not depend on the radius.
+class GuidedFilter
+{
+public:
+    GuidedFilter();
+    //epsilon: variance below which details count as noise (for intensities 0..1, e.g. 0.05^2)
+    void apply(IntensityMap &map, int radius, double epsilon, bool tileable) const;
+    void setProgress(GeneratorProgress *progress);
+
+private:
+    typedef std::vector< double, PoolAllocator<double> > Table;
+    //the coefficients only need float precision, their sums are accumulated in the tables
+    typedef std::vector< float, PoolAllocator<float> > Plane;
+
+    GeneratorProgress *progress;
+
+    void buildTable(Table &table, int width, int height) const;
+    double boxSum(const Table &table, int width, int x0, int y0, int x1, int y1) const;
+    double boxMean(const Table &table, int width, int height, int x, int y, int radius, bool tileable) const;
+};
+
+#endif // GUIDEDFILTER_H
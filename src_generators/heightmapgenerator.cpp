@@ -0,0 +1,413 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#include "heightmapgenerator.h"
+#include <cmath>
+
+//steepest slope taken from a normal, normals pointing sideways or down would be infinitely steep
+static const float HEIGHTMAP_MIN_NORMAL_Z = 0.05f;
+//the coarsest grid is solved by smoothing alone
+static const int HEIGHTMAP_COARSEST_SIZE = 4;
+static const int HEIGHTMAP_MAX_CYCLES = 30;
+//solving stops when the residual dropped below this fraction of the right hand side
+static const double HEIGHTMAP_TOLERANCE = 1.0e-4;
+//a V-cycle reduces the residual by about a factor of 10 (less for image sizes that are not divisible
+//by a power of two), if it barely changes the float precision is reached
+static const double HEIGHTMAP_MIN_CONVERGENCE = 0.9;
+
+HeightmapGenerator::HeightmapGenerator()
+    : tileable(false), progress(0)
+{
+}
+
+//optional, V-cycles are reported to it and it can cancel the calculation
+void HeightmapGenerator::setProgress(GeneratorProgress *progress) {
+    this->progress = progress;
+}
+
+IntensityMap HeightmapGenerator::calculateHeightmap(const NormalField &normals, bool tileable, bool invert) {
+    this->tileable = tileable;
+
+    const int width = normals.getWidth();
+    const int height = normals.getHeight();
+    if(width == 0 || height == 0)
+        return IntensityMap();
+
+    //slopes of the height field (same orientation as the normals the NormalmapGenerator creates)
+    const float *nx = normals.planeX();
+    const float *ny = normals.planeY();
+    const float *nz = normals.planeZ();
+    const float sign = invert ? 1.0f : -1.0f;
+
+    //build the grid hierarchy. The levels are created in place, copying them would copy their buffers
+    int levelCount = 1;
+    for(int size = std::min(width, height); size > HEIGHTMAP_COARSEST_SIZE; size = (size + 1) / 2)
+        levelCount++;
+
+    std::vector<Level> levels(levelCount);
+    int levelWidth = width;
+    int levelHeight = height;
+    float spacingSquared = 1.0f;
+
+    for(int i = 0; i < levelCount; i++) {
+        Level &level = levels[i];
+        level.width = levelWidth;
+        level.height = levelHeight;
+        level.spacingSquared = spacingSquared;
+        level.solution.assign((size_t)levelWidth * levelHeight, 0.0f);
+        level.rhs.assign((size_t)levelWidth * levelHeight, 0.0f);
+        level.residual.assign((size_t)levelWidth * levelHeight, 0.0f);
+
+        levelWidth = (levelWidth + 1) / 2;
+        levelHeight = (levelHeight + 1) / 2;
+        spacingSquared *= 4.0f;
+    }
+
+    //right hand side: divergence of the slopes. The slopes are averaged onto the borders between
+    //the pixels, with mirrored borders nothing flows over the image border
+    Level &finest = levels[0];
+
+    #pragma omp parallel for  // OpenMP
+    for(int y = 0; y < height; y++) {
+        const size_t row = (size_t)y * width;
+        const size_t rowAbove = (size_t)handleEdges(y - 1, height) * width;
+        const size_t rowBelow = (size_t)handleEdges(y + 1, height) * width;
+
+        for(int x = 0; x < width; x++) {
+            const size_t pos = row + x;
+            float divergence = 0.0f;
+
+            //computed on the fly instead of in two extra image sized buffers
+            const float slopeX = sign * nx[pos] / std::max(nz[pos], HEIGHTMAP_MIN_NORMAL_Z);
+            const float slopeY = sign * ny[pos] / std::max(nz[pos], HEIGHTMAP_MIN_NORMAL_Z);
+
+            if(tileable || x < width - 1) {
+                const size_t right = row + handleEdges(x + 1, width);
+                divergence += 0.5f * (slopeX + sign * nx[right] / std::max(nz[right], HEIGHTMAP_MIN_NORMAL_Z));
+            }
+            if(tileable || x > 0) {
+                const size_t left = row + handleEdges(x - 1, width);
+                divergence -= 0.5f * (slopeX + sign * nx[left] / std::max(nz[left], HEIGHTMAP_MIN_NORMAL_Z));
+            }
+            if(tileable || y < height - 1) {
+                const size_t below = rowBelow + x;
+                divergence += 0.5f * (slopeY + sign * ny[below] / std::max(nz[below], HEIGHTMAP_MIN_NORMAL_Z));
+            }
+            if(tileable || y > 0) {
+                const size_t above = rowAbove + x;
+                divergence -= 0.5f * (slopeY + sign * ny[above] / std::max(nz[above], HEIGHTMAP_MIN_NORMAL_Z));
+            }
+
+            finest.rhs[pos] = divergence;
+        }
+    }
+
+    //the height is only defined up to a constant, the equation has a solution if the divergence sums up to 0
+    subtractMean(finest.rhs);
+
+    const double rhsNorm = rootMeanSquare(finest.rhs);
+    double previousResidualNorm = rhsNorm;
+
+    if(progress)
+        progress->addWork(HEIGHTMAP_MAX_CYCLES);
+
+    //full multigrid start: the problem is solved on the coarse grids first and every solution is
+    //the starting point of the next finer grid, the finest grid then only needs one or two V-cycles
+    if(rhsNorm > 0.0) {
+        for(size_t i = 0; i + 1 < levels.size(); i++)
+            restrict(levels[i], levels[i].rhs, levels[i + 1]);
+
+        smooth(levels.back(), 50);
+        for(size_t i = levels.size() - 1; i > 0; i--) {
+            if(progress && progress->isCanceled())
+                break;
+
+            prolongate(levels[i], levels[i - 1]);
+            vCycle(levels, i - 1);
+        }
+    }
+
+    for(int cycle = 0; cycle < HEIGHTMAP_MAX_CYCLES && rhsNorm > 0.0; cycle++) {
+        if(progress && progress->isCanceled())
+            break;
+
+        //stop when the residual is small enough or does not shrink anymore (float precision is reached)
+        calculateResidual(finest);
+        const double residualNorm = rootMeanSquare(finest.residual);
+        if(residualNorm < HEIGHTMAP_TOLERANCE * rhsNorm || residualNorm > HEIGHTMAP_MIN_CONVERGENCE * previousResidualNorm) {
+            //report the skipped cycles as done
+            if(progress)
+                progress->advance(HEIGHTMAP_MAX_CYCLES - cycle);
+            break;
+        }
+
+        previousResidualNorm = residualNorm;
+        vCycle(levels, 0);
+
+        if(progress)
+            progress->advance();
+    }
+
+    //normalize to 0..1
+    float minHeight = finest.solution[0];
+    float maxHeight = finest.solution[0];
+
+    #pragma omp parallel for reduction(min:minHeight) reduction(max:maxHeight)  // OpenMP
+    for(int i = 1; i < width * height; i++) {
+        minHeight = std::min(minHeight, finest.solution[i]);
+        maxHeight = std::max(maxHeight, finest.solution[i]);
+    }
+    const float range = (maxHeight > minHeight) ? maxHeight - minHeight : 1.0f;
+
+    IntensityMap result(width, height);
+    double *resultData = result.data();
+
+    #pragma omp parallel for  // OpenMP
+    for(int i = 0; i < width * height; i++) {
+        resultData[i] = (finest.solution[i] - minHeight) / range;
+    }
+
+    return result;
+}
+
+void HeightmapGenerator::vCycle(std::vector<Level> &levels, size_t index) const {
+    Level &level = levels[index];
+
+    if(index + 1 == levels.size()) {
+        //coarsest grid, only a few pixels
+        smooth(level, 50);
+        return;
+    }
+
+    Level &coarse = levels[index + 1];
+
+    smooth(level, 2);
+    calculateResidual(level);
+    restrict(level, level.residual, coarse);
+
+    std::fill(coarse.solution.begin(), coarse.solution.end(), 0.0f);
+    vCycle(levels, index + 1);
+
+    prolongate(coarse, level);
+    smooth(level, 2);
+}
+
+// Red-black Gauss-Seidel: all pixels of one color only depend on pixels of the other color,
+// so the rows of a half sweep can be updated in parallel.
+void HeightmapGenerator::smooth(Level &level, int iterations) const {
+    const int height = level.height;
+
+    //with an odd number of rows the first and last row have the same color pattern and are neighbours
+    //when wrapping around, so the last row is updated after the others
+    const int parallelRows = (tileable && height % 2 == 1) ? height - 1 : height;
+
+    for(int iteration = 0; iteration < iterations; iteration++) {
+        for(int color = 0; color < 2; color++) {
+            #pragma omp parallel for  // OpenMP
+            for(int y = 0; y < parallelRows; y++) {
+                smoothRow(level, y, color);
+            }
+
+            for(int y = parallelRows; y < height; y++) {
+                smoothRow(level, y, color);
+            }
+        }
+    }
+}
+
+void HeightmapGenerator::smoothRow(Level &level, int y, int color) const {
+    const int width = level.width;
+    const int height = level.height;
+    float *row = &level.solution[(size_t)y * width];
+    const float *rhsRow = &level.rhs[(size_t)y * width];
+    const float spacingSquared = level.spacingSquared;
+    const int firstX = (y + color) & 1;
+
+    //mirrored borders have fewer neighbours, rows at the top and bottom take the slow path
+    if(!tileable && (y == 0 || y == height - 1)) {
+        for(int x = firstX; x < width; x += 2) {
+            row[x] = relaxPixel(level, x, y);
+        }
+        return;
+    }
+
+    const float *rowAbove = &level.solution[(size_t)handleEdges(y - 1, height) * width];
+    const float *rowBelow = &level.solution[(size_t)handleEdges(y + 1, height) * width];
+
+    for(int x = firstX; x < width; x += 2) {
+        if(x == 0 || x == width - 1)
+            row[x] = relaxPixel(level, x, y);
+        else
+            row[x] = (row[x - 1] + row[x + 1] + rowAbove[x] + rowBelow[x] - spacingSquared * rhsRow[x]) * 0.25f;
+    }
+}
+
+//Gauss-Seidel update of one pixel, with edge handling
+float HeightmapGenerator::relaxPixel(const Level &level, int x, int y) const {
+    const int width = level.width;
+    const int height = level.height;
+    const float *solution = &level.solution[0];
+    float sum = 0.0f;
+    int count = 0;
+
+    if(tileable) {
+        sum = solution[(size_t)y * width + handleEdges(x - 1, width)]
+            + solution[(size_t)y * width + handleEdges(x + 1, width)]
+            + solution[(size_t)handleEdges(y - 1, height) * width + x]
+            + solution[(size_t)handleEdges(y + 1, height) * width + x];
+        count = 4;
+    }
+    else {
+        //mirrored borders: no flow over the border, the missing neighbours are left out
+        if(x > 0)          { sum += solution[(size_t)y * width + x - 1]; count++; }
+        if(x < width - 1)  { sum += solution[(size_t)y * width + x + 1]; count++; }
+        if(y > 0)          { sum += solution[(size_t)(y - 1) * width + x]; count++; }
+        if(y < height - 1) { sum += solution[(size_t)(y + 1) * width + x]; count++; }
+    }
+
+    if(count == 0)
+        return solution[(size_t)y * width + x];
+
+    return (sum - level.spacingSquared * level.rhs[(size_t)y * width + x]) / count;
+}
+
+//residual = rhs - laplacian(solution)
+void HeightmapGenerator::calculateResidual(Level &level) const {
+    const int width = level.width;
+    const int height = level.height;
+    const float *solution = &level.solution[0];
+    const float spacingSquaredInv = 1.0f / level.spacingSquared;
+
+    #pragma omp parallel for  // OpenMP
+    for(int y = 0; y < height; y++) {
+        const float *row = &solution[(size_t)y * width];
+        const float *rowAbove = &solution[(size_t)handleEdges(y - 1, height) * width];
+        const float *rowBelow = &solution[(size_t)handleEdges(y + 1, height) * width];
+        const float *rhsRow = &level.rhs[(size_t)y * width];
+        float *residualRow = &level.residual[(size_t)y * width];
+        const bool borderRow = !tileable && (y == 0 || y == height - 1);
+
+        for(int x = 0; x < width; x++) {
+            if(borderRow || x == 0 || x == width - 1) {
+                //relaxPixel() gives the value that makes the residual 0, the residual is proportional to the difference
+                const float relaxed = relaxPixel(level, x, y);
+                int count = 4;
+                if(!tileable)
+                    count = (x > 0) + (x < width - 1) + (y > 0) + (y < height - 1);
+                residualRow[x] = (row[x] - relaxed) * count * spacingSquaredInv;
+            }
+            else {
+                residualRow[x] = rhsRow[x] - (row[x - 1] + row[x + 1] + rowAbove[x] + rowBelow[x] - 4.0f * row[x]) * spacingSquaredInv;
+            }
+        }
+    }
+}
+
+//averages 2x2 blocks of values of the fine grid (its residual or right hand side) into the right hand side of the coarse grid
+void HeightmapGenerator::restrict(const Level &fine, const Buffer &values, Level &coarse) const {
+    #pragma omp parallel for  // OpenMP
+    for(int y = 0; y < coarse.height; y++) {
+        for(int x = 0; x < coarse.width; x++) {
+            float sum = 0.0f;
+            int count = 0;
+
+            //with odd sizes the last coarse pixel covers only one fine pixel
+            for(int fy = 2 * y; fy < std::min(2 * y + 2, fine.height); fy++) {
+                for(int fx = 2 * x; fx < std::min(2 * x + 2, fine.width); fx++) {
+                    sum += values[(size_t)fy * fine.width + fx];
+                    count++;
+                }
+            }
+
+            coarse.rhs[(size_t)y * coarse.width + x] = sum / count;
+        }
+    }
+
+    subtractMean(coarse.rhs);
+}
+
+//bilinear interpolation of the coarse correction, added to the fine solution
+void HeightmapGenerator::prolongate(const Level &coarse, Level &fine) const {
+    //pixel centers of the fine grid in coarse grid coordinates, the same for every row
+    std::vector<int> columns0(fine.width);
+    std::vector<int> columns1(fine.width);
+    std::vector<float> weights(fine.width);
+    for(int x = 0; x < fine.width; x++) {
+        const float coarseX = (x + 0.5f) * 0.5f - 0.5f;
+        const int x0 = (int)floor(coarseX);
+        columns0[x] = handleEdges(x0, coarse.width);
+        columns1[x] = handleEdges(x0 + 1, coarse.width);
+        weights[x] = coarseX - x0;
+    }
+
+    #pragma omp parallel for  // OpenMP
+    for(int y = 0; y < fine.height; y++) {
+        const float coarseY = (y + 0.5f) * 0.5f - 0.5f;
+        const int y0 = (int)floor(coarseY);
+        const float fy = coarseY - y0;
+        const float *row0 = &coarse.solution[(size_t)handleEdges(y0, coarse.height) * coarse.width];
+        const float *row1 = &coarse.solution[(size_t)handleEdges(y0 + 1, coarse.height) * coarse.width];
+        float *fineRow = &fine.solution[(size_t)y * fine.width];
+
+        for(int x = 0; x < fine.width; x++) {
+            const float fx = weights[x];
+            const float top = row0[columns0[x]] * (1.0f - fx) + row0[columns1[x]] * fx;
+            const float bottom = row1[columns0[x]] * (1.0f - fx) + row1[columns1[x]] * fx;
+            fineRow[x] += top * (1.0f - fy) + bottom * fy;
+        }
+    }
+}
+
+double HeightmapGenerator::rootMeanSquare(const Buffer &buffer) const {
+    double sum = 0.0;
+
+    #pragma omp parallel for reduction(+:sum)  // OpenMP
+    for(int i = 0; i < (int)buffer.size(); i++) {
+        sum += (double)buffer[i] * buffer[i];
+    }
+
+    return sqrt(sum / buffer.size());
+}
+
+void HeightmapGenerator::subtractMean(Buffer &buffer) const {
+    double sum = 0.0;
+
+    #pragma omp parallel for reduction(+:sum)  // OpenMP
+    for(int i = 0; i < (int)buffer.size(); i++) {
+        sum += buffer[i];
+    }
+
+    const float mean = (float)(sum / buffer.size());
+
+    #pragma omp parallel for  // OpenMP
+    for(int i = 0; i < (int)buffer.size(); i++) {
+        buffer[i] -= mean;
+    }
+}
+
+int HeightmapGenerator::handleEdges(int iterator, int max) const {
+    if(tileable) {
+        const int wrapped = iterator % max;
+        return wrapped < 0 ? wrapped + max : wrapped;
+    }
+
+    return std::min(std::max(iterator, 0), max - 1);
+}
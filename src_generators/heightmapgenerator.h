@@ -0,0 +1,68 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#ifndef HEIGHTMAPGENERATOR_H
+#define HEIGHTMAPGENERATOR_H
+
+#include "intensitymap.h"
+#include "normalfield.h"
+#include "generatorprogress.h"
+
+// Integrates a normalmap back into a height field. The slopes given by the normals
+// are turned into a Poisson equation (laplacian of the height = divergence of the slopes),
+// which is solved with multigrid V-cycles in roughly linear time.
+class HeightmapGenerator
+{
+public:
+    HeightmapGenerator();
+    //the result is normalized to 0..1
+    IntensityMap calculateHeightmap(const NormalField &normals, bool tileable, bool invert = false);
+    void setProgress(GeneratorProgress *progress);
+
+private:
+    typedef std::vector< float, PoolAllocator<float> > Buffer;
+
+    //one grid of the multigrid hierarchy, every level has half the resolution of the previous one
+    struct Level {
+        int width, height;
+        //squared grid spacing in pixels of the full resolution
+        float spacingSquared;
+        Buffer solution;
+        Buffer rhs;
+        Buffer residual;
+    };
+
+    bool tileable;
+    GeneratorProgress *progress;
+
+    void vCycle(std::vector<Level> &levels, size_t index) const;
+    void smooth(Level &level, int iterations) const;
+    void smoothRow(Level &level, int y, int color) const;
+    float relaxPixel(const Level &level, int x, int y) const;
+    void calculateResidual(Level &level) const;
+    void restrict(const Level &fine, const Buffer &values, Level &coarse) const;
+    void prolongate(const Level &coarse, Level &fine) const;
+    double rootMeanSquare(const Buffer &buffer) const;
+    void subtractMean(Buffer &buffer) const;
+    int handleEdges(int iterator, int max) const;
+};
+
+#endif // HEIGHTMAPGENERATOR_H
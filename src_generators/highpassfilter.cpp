@@ -0,0 +1,175 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#include "highpassfilter.h"
+#include <cmath>
+
+//the blur has a standard deviation of this many cells of the coarse grid
+static const double HIGHPASS_SIGMA_CELLS = 4.0;
+//passes of the box blur that approximates the gaussian
+static const int HIGHPASS_BOX_PASSES = 3;
+
+HighPassFilter::HighPassFilter()
+    : progress(0)
+{
+}
+
+//optional, rows are reported to it and it can cancel the calculation
+void HighPassFilter::setProgress(GeneratorProgress *progress) {
+    this->progress = progress;
+}
+
+void HighPassFilter::apply(IntensityMap &map, double radius, bool tileable, bool invert) const {
+    const int width = map.getWidth();
+    const int height = map.getHeight();
+    if(width == 0 || height == 0 || radius <= 0.0)
+        return;
+
+    if(progress)
+        progress->addWork(2 * height);
+
+    //coarse grid, pixel x belongs to cell x * coarseWidth / width
+    const double cellSize = std::max(radius / HIGHPASS_SIGMA_CELLS, 1.0);
+    const int coarseWidth = std::max((int)std::lround(width / cellSize), 1);
+    const int coarseHeight = std::max((int)std::lround(height / cellSize), 1);
+    Buffer coarse((size_t)coarseWidth * coarseHeight, 0.0f);
+    double *data = map.data();
+
+    //average of every cell
+    #pragma omp parallel for  // OpenMP
+    for(int cy = 0; cy < coarseHeight; cy++) {
+        if(progress && progress->isCanceled())
+            continue;
+
+        const int firstRow = (int)((long long)cy * height / coarseHeight);
+        const int lastRow = (int)((long long)(cy + 1) * height / coarseHeight);
+        std::vector<double> sums(coarseWidth, 0.0);
+        std::vector<int> counts(coarseWidth, 0);
+
+        for(int y = firstRow; y < lastRow; y++) {
+            const double *row = data + (size_t)y * width;
+            for(int x = 0; x < width; x++) {
+                const int cx = (int)((long long)x * coarseWidth / width);
+                sums[cx] += row[x];
+                counts[cx]++;
+            }
+        }
+
+        for(int cx = 0; cx < coarseWidth; cx++) {
+            coarse[(size_t)cy * coarseWidth + cx] = counts[cx] > 0 ? sums[cx] / counts[cx] : 0.0f;
+        }
+
+        if(progress)
+            progress->advance(lastRow - firstRow);
+    }
+
+    if(progress && progress->isCanceled())
+        return;
+
+    //repeated box blurs of the coarse grid, the box size for a gaussian:
+    //variance of n boxes with width 2r + 1 is n * ((2r + 1)^2 - 1) / 12
+    const double sigmaX = radius * coarseWidth / width;
+    const double sigmaY = radius * coarseHeight / height;
+    const int boxRadiusX = (int)std::lround((std::sqrt(12.0 * sigmaX * sigmaX / HIGHPASS_BOX_PASSES + 1.0) - 1.0) / 2.0);
+    const int boxRadiusY = (int)std::lround((std::sqrt(12.0 * sigmaY * sigmaY / HIGHPASS_BOX_PASSES + 1.0) - 1.0) / 2.0);
+
+    for(int pass = 0; pass < HIGHPASS_BOX_PASSES; pass++) {
+        #pragma omp parallel for  // OpenMP
+        for(int cy = 0; cy < coarseHeight; cy++) {
+            std::vector<float> scratch(coarseWidth);
+            boxBlurLine(&coarse[(size_t)cy * coarseWidth], coarseWidth, 1, boxRadiusX, tileable, &scratch[0]);
+        }
+
+        #pragma omp parallel for  // OpenMP
+        for(int cx = 0; cx < coarseWidth; cx++) {
+            std::vector<float> scratch(coarseHeight);
+            boxBlurLine(&coarse[cx], coarseHeight, coarseWidth, boxRadiusY, tileable, &scratch[0]);
+        }
+    }
+
+    //the blur keeps the mean, it is added back so the brightness does not change
+    double mean = 0.0;
+    for(size_t i = 0; i < coarse.size(); i++) {
+        mean += coarse[i];
+    }
+    mean /= coarse.size();
+
+    //subtract the bilinearly interpolated coarse grid
+    const double scaleX = (double)coarseWidth / width;
+    const double scaleY = (double)coarseHeight / height;
+
+    #pragma omp parallel for  // OpenMP
+    for(int y = 0; y < height; y++) {
+        if(progress && progress->isCanceled())
+            continue;
+
+        const double v = (y + 0.5) * scaleY - 0.5;
+        const int cy0 = (int)std::floor(v);
+        const float fy = v - cy0;
+        const float *row0 = &coarse[(size_t)handleEdges(cy0, coarseHeight, tileable) * coarseWidth];
+        const float *row1 = &coarse[(size_t)handleEdges(cy0 + 1, coarseHeight, tileable) * coarseWidth];
+        double *row = data + (size_t)y * width;
+
+        for(int x = 0; x < width; x++) {
+            const double u = (x + 0.5) * scaleX - 0.5;
+            const int cx0 = (int)std::floor(u);
+            const float fx = u - cx0;
+            const int x0 = handleEdges(cx0, coarseWidth, tileable);
+            const int x1 = handleEdges(cx0 + 1, coarseWidth, tileable);
+
+            const float top = row0[x0] + (row0[x1] - row0[x0]) * fx;
+            const float bottom = row1[x0] + (row1[x1] - row1[x0]) * fx;
+            const double highPass = row[x] - (top + (bottom - top) * fy) + mean;
+
+            row[x] = invert ? 1.0 - highPass : highPass;
+        }
+
+        if(progress)
+            progress->advance();
+    }
+}
+
+//box blur with a running sum, the cost does not depend on the radius
+void HighPassFilter::boxBlurLine(float *line, int count, int stride, int radius, bool tileable, float *scratch) const {
+    for(int i = 0; i < count; i++) {
+        scratch[i] = line[(size_t)i * stride];
+    }
+
+    double sum = 0.0;
+    for(int i = -radius; i <= radius; i++) {
+        sum += scratch[handleEdges(i, count, tileable)];
+    }
+
+    const double norm = 1.0 / (2 * radius + 1);
+
+    for(int i = 0; i < count; i++) {
+        line[(size_t)i * stride] = sum * norm;
+        sum += scratch[handleEdges(i + radius + 1, count, tileable)] - scratch[handleEdges(i - radius, count, tileable)];
+    }
+}
+
+//wraps around for tileable maps (also if the iterator is more than one size away), repeats the edge otherwise
+int HighPassFilter::handleEdges(int iterator, int max, bool tileable) const {
+    if(tileable)
+        return ((iterator % max) + max) % max;
+
+    return std::min(std::max(iterator, 0), max - 1);
+}
@@ -0,0 +1,50 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#ifndef HIGHPASSFILTER_H
+#define HIGHPASSFILTER_H
+
+#include "intensitymap.h"
+#include "generatorprogress.h"
+
+// Removes the low frequencies (e.g. lighting gradients of a photo) from an intensity map
+// by subtracting a gaussian blurred copy with a large radius. The blurred copy only contains
+// low frequencies, so it is calculated on a grid that is coarser by about a quarter of the radius:
+// the cost does not grow with the radius and no second full size map is needed.
+class HighPassFilter
+{
+public:
+    HighPassFilter();
+    //radius is the standard deviation of the blur in pixels, the mean brightness is kept.
+    //invert: the result is inverted in the same pass (like IntensityMap::invert())
+    void apply(IntensityMap &map, double radius, bool tileable, bool invert = false) const;
+    void setProgress(GeneratorProgress *progress);
+
+private:
+    typedef std::vector< float, PoolAllocator<float> > Buffer;
+
+    GeneratorProgress *progress;
+
+    void boxBlurLine(float *line, int count, int stride, int radius, bool tileable, float *scratch) const;
+    int handleEdges(int iterator, int max, bool tileable) const;
+};
+
+#endif // HIGHPASSFILTER_H
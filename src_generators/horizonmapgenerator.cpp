@@ -0,0 +1,167 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#include "horizonmapgenerator.h"
+#include <QPoint>
+#include <cmath>
+
+//steps of the 8 directions
+static const int HORIZON_STEP_X[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+static const int HORIZON_STEP_Y[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+
+HorizonMapGenerator::HorizonMapGenerator()
+    : progress(0)
+{
+}
+
+//optional, scanlines are reported to it and it can cancel the calculation
+void HorizonMapGenerator::setProgress(GeneratorProgress *progress) {
+    this->progress = progress;
+}
+
+QImage HorizonMapGenerator::calculateHorizonMap(const IntensityMap &heightmap, double depth, bool tileable, Direction firstDirection) {
+    const int width = heightmap.getWidth();
+    const int height = heightmap.getHeight();
+    if(width == 0 || height == 0)
+        return QImage();
+
+    QImage result(width, height, QImage::Format_ARGB32);
+    result.fill(0);
+
+    //scanlines of the 4 directions
+    if(progress) {
+        long long scanlines = 0;
+        for(int i = 0; i < 4; i++)
+            scanlines += scanlineCount(width, height, firstDirection + i);
+        progress->addWork(scanlines);
+    }
+
+    //channels in memory order of the QRgb: red, green, blue, alpha
+    const int shifts[4] = { 16, 8, 0, 24 };
+
+    for(int i = 0; i < 4; i++) {
+        if(progress && progress->isCanceled())
+            break;
+
+        sweepDirection(heightmap, depth, tileable, firstDirection + i, shifts[i], result);
+    }
+
+    return result;
+}
+
+//a scanline per row (east, west), per column (north, south) or per diagonal (width + height - 1 of them)
+long long HorizonMapGenerator::scanlineCount(int width, int height, int direction) {
+    if(HORIZON_STEP_X[direction] != 0 && HORIZON_STEP_Y[direction] != 0)
+        return (long long)width + height - 1;
+    if(HORIZON_STEP_X[direction] != 0)
+        return height;
+    return width;
+}
+
+//horizon of every pixel looking in the direction, stored in the byte of the QRgb at shift
+void HorizonMapGenerator::sweepDirection(const IntensityMap &heightmap, double depth, bool tileable, int direction, int shift, QImage &result) const {
+    const int width = heightmap.getWidth();
+    const int height = heightmap.getHeight();
+    const int stepX = HORIZON_STEP_X[direction];
+    const int stepY = HORIZON_STEP_Y[direction];
+    const float stepLength = std::sqrt((float)(stepX * stepX + stepY * stepY));
+    const double *heights = heightmap.data();
+    const int bytesPerLine = result.bytesPerLine();
+    uchar *bits = result.bits();
+
+    //a scanline starts at every border pixel whose predecessor is outside
+    std::vector<QPoint> starts;
+    for(int y = 0; y < height; y++) {
+        for(int x = 0; x < width; x++) {
+            if(y != 0 && y != height - 1 && x != 0 && x != width - 1)
+                x = width - 2;
+
+            const int previousX = x - stepX;
+            const int previousY = y - stepY;
+            if(previousX < 0 || previousX >= width || previousY < 0 || previousY >= height)
+                starts.push_back(QPoint(x, y));
+        }
+    }
+
+    //tileable: the heights behind the end of a scanline (wrapped around) can block the light too,
+    //one image size of them is added
+    const int wrapLength = tileable ? std::max(width, height) : 0;
+    const float scale = depth;
+
+    #pragma omp parallel for schedule(dynamic, 16)  // OpenMP
+    for(int line = 0; line < (int)starts.size(); line++) {
+        if(progress && progress->isCanceled())
+            continue;
+
+        const QPoint start = starts[line];
+        int length = 0;
+        while(true) {
+            const int x = start.x() + length * stepX;
+            const int y = start.y() + length * stepY;
+            if(x < 0 || x >= width || y < 0 || y >= height)
+                break;
+            length++;
+        }
+
+        //positions along the line and the upper convex hull of the heights ahead
+        std::vector<float> hullPosition;
+        std::vector<float> hullHeight;
+        hullPosition.reserve(64);
+        hullHeight.reserve(64);
+
+        for(int t = length + wrapLength - 1; t >= 0; t--) {
+            const int x = ((start.x() + t * stepX) % width + width) % width;
+            const int y = ((start.y() + t * stepY) % height + height) % height;
+            const float position = t * stepLength;
+            const float h = heights[(size_t)y * width + x] * scale;
+
+            //remove hull points below the line from this pixel to the point behind them
+            while(hullPosition.size() >= 2) {
+                const size_t top = hullPosition.size() - 1;
+                const float slopeTop = (hullHeight[top] - h) / (hullPosition[top] - position);
+                const float slopeBehind = (hullHeight[top - 1] - h) / (hullPosition[top - 1] - position);
+                if(slopeBehind < slopeTop)
+                    break;
+                hullPosition.pop_back();
+                hullHeight.pop_back();
+            }
+
+            if(t < length) {
+                float sine = 0.0f;
+                if(!hullPosition.empty()) {
+                    const float rise = hullHeight.back() - h;
+                    const float distance = hullPosition.back() - position;
+                    if(rise > 0.0f)
+                        sine = rise / std::sqrt(rise * rise + distance * distance);
+                }
+
+                QRgb *pixel = (QRgb*)(bits + (size_t)y * bytesPerLine) + x;
+                *pixel |= (QRgb)(sine * 255.0f + 0.5f) << shift;
+            }
+
+            hullPosition.push_back(position);
+            hullHeight.push_back(h);
+        }
+
+        if(progress)
+            progress->advance();
+    }
+}
@@ -0,0 +1,55 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#ifndef HORIZONMAPGENERATOR_H
+#define HORIZONMAPGENERATOR_H
+
+#include <QImage>
+#include "intensitymap.h"
+#include "generatorprogress.h"
+
+// Horizon maps for self shadowing with parallax mapping: for every pixel and 8 directions
+// the elevation of the horizon, stored as its sine (0 = nothing blocks the light, 1 = straight up).
+// Every direction is swept along its scanlines from the far end, keeping the upper convex hull
+// of the heights seen so far: the horizon is the tangent from a pixel to this hull,
+// so each scanline is done in linear time no matter how far the shadows reach.
+class HorizonMapGenerator
+{
+public:
+    // directions, x to the right and y down
+    enum Direction {
+        EAST, SOUTH_EAST, SOUTH, SOUTH_WEST, WEST, NORTH_WEST, NORTH, NORTH_EAST
+    };
+
+    HorizonMapGenerator();
+    //4 directions from firstDirection on in the R, G, B and A channels (EAST and WEST give the 2 textures).
+    //depth: height of the intensity 1 in pixels
+    QImage calculateHorizonMap(const IntensityMap &heightmap, double depth, bool tileable, Direction firstDirection);
+    void setProgress(GeneratorProgress *progress);
+
+private:
+    GeneratorProgress *progress;
+
+    void sweepDirection(const IntensityMap &heightmap, double depth, bool tileable, int direction, int channel, QImage &result) const;
+    static long long scanlineCount(int width, int height, int direction);
+};
+
+#endif // HORIZONMAPGENERATOR_H
@@ -0,0 +1,122 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#include "imagesequence.h"
+#include <QFileInfo>
+#include <QDir>
+#include <QRegularExpression>
+#include <QCryptographicHash>
+#include <vector>
+#include <algorithm>
+
+ImageSequence::ImageSequence(const QString &framePath) {
+    //name, separator, frame number (the last digits before the suffix), file suffix
+    const QFileInfo file(framePath);
+    const QRegularExpression frameName("^(.*?)([._-]?)(\\d+)\\.([^.]+)$");
+    const QRegularExpressionMatch match = frameName.match(file.fileName());
+    if(!match.hasMatch())
+        return;
+
+    const QString name = match.captured(1);
+    const QString number = match.captured(3);
+    separator = match.captured(2);
+    suffix = match.captured(4);
+    prefix = file.absolutePath() + "/" + name;
+    //zero padded numbers all have the same length (0001 ... 0120), others not (1 ... 120)
+    const bool padded = number.startsWith("0");
+
+    const QDir dir = file.absoluteDir();
+    const QStringList candidates = dir.entryList(QStringList() << name + separator + "*." + suffix, QDir::Files);
+
+    std::vector<std::pair<long long, int> > frames;
+    QStringList framePaths;
+    QStringList frameNumbers;
+    for(int i = 0; i < candidates.size(); i++) {
+        const QRegularExpressionMatch frameMatch = frameName.match(candidates.at(i));
+        if(!frameMatch.hasMatch() || frameMatch.captured(1) != name || frameMatch.captured(2) != separator ||
+                frameMatch.captured(4) != suffix)
+            continue;
+
+        const QString frameNumber = frameMatch.captured(3);
+        if(padded && frameNumber.length() != number.length())
+            continue;
+
+        frames.push_back(std::make_pair(frameNumber.toLongLong(), (int)framePaths.size()));
+        framePaths.append(dir.absoluteFilePath(candidates.at(i)));
+        frameNumbers.append(frameNumber);
+    }
+
+    std::sort(frames.begin(), frames.end());
+    for(size_t i = 0; i < frames.size(); i++) {
+        paths.append(framePaths.at(frames[i].second));
+        numbers.append(frameNumbers.at(frames[i].second));
+    }
+}
+
+bool ImageSequence::isEmpty() const {
+    return paths.isEmpty();
+}
+
+int ImageSequence::count() const {
+    return paths.size();
+}
+
+QString ImageSequence::getFramePath(int frame) const {
+    return paths.at(frame);
+}
+
+QString ImageSequence::getFrameNumber(int frame) const {
+    return numbers.at(frame);
+}
+
+QString ImageSequence::getPrefix() const {
+    return prefix;
+}
+
+QString ImageSequence::getSeparator() const {
+    return separator;
+}
+
+QString ImageSequence::getSuffix() const {
+    return suffix;
+}
+
+ImageSequence::Frame ImageSequence::loadFrame(int frame) const {
+    Frame result;
+    result.image = QImage(paths.at(frame));
+    if(!result.image.isNull())
+        result.hash = hash(result.image);
+    return result;
+}
+
+QByteArray ImageSequence::hash(const QImage &image) {
+    QCryptographicHash hash(QCryptographicHash::Md5);
+
+    const int header[3] = { image.width(), image.height(), (int)image.format() };
+    hash.addData((const char*)header, sizeof(header));
+
+    //line by line, the padding at the end of the scanlines is undefined
+    const int lineBytes = (int)(((long long)image.width() * image.depth() + 7) / 8);
+    for(int y = 0; y < image.height(); y++)
+        hash.addData((const char*)image.constScanLine(y), lineBytes);
+
+    return hash.result();
+}
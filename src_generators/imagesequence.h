@@ -0,0 +1,67 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#ifndef IMAGESEQUENCE_H
+#define IMAGESEQUENCE_H
+
+#include <QImage>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+
+// The frames of a numbered image sequence (fire_0001.png, fire_0002.png ...), found from
+// any one of its frames. Frames are sorted by their number, which is kept as written in
+// the file name (with leading zeros) so the maps can be named the same way.
+class ImageSequence
+{
+public:
+    //a decoded frame and the hash of its pixels
+    struct Frame {
+        QImage image;
+        QByteArray hash;
+    };
+
+    //path of any frame of the sequence
+    explicit ImageSequence(const QString &framePath);
+    bool isEmpty() const;
+    int count() const;
+    QString getFramePath(int frame) const;
+    //frame number as written in the file name, e.g. "0001"
+    QString getFrameNumber(int frame) const;
+    //path of the sequence without separator and frame number (folder/name)
+    QString getPrefix() const;
+    //character between the name and the frame number (".", "_", "-" or nothing)
+    QString getSeparator() const;
+    QString getSuffix() const;
+    //loads and hashes a frame, can be called from another thread
+    Frame loadFrame(int frame) const;
+    //hash of the size, format and pixels of an image, equal for identical frames
+    static QByteArray hash(const QImage &image);
+
+private:
+    QString prefix;
+    QString separator;
+    QString suffix;
+    QStringList paths;
+    QStringList numbers;
+};
+
+#endif // IMAGESEQUENCE_H
@@ -23,17 +23,19 @@
 #include <QColor>
 #include <iostream>
 
-IntensityMap::IntensityMap() {
-
+IntensityMap::IntensityMap()
+    : width(0), height(0)
+{
 }
 
-IntensityMap::IntensityMap(int width, int height) {
-    map = std::vector< std::vector<double> >(height, std::vector<double>(width, 0.0));
+IntensityMap::IntensityMap(int width, int height)
+    : width(width), height(height), map((size_t)width * height, 0.0)
+{
 }
 
 IntensityMap::IntensityMap(const QImage& rgbImage, Mode mode, bool useRed, bool useGreen, bool useBlue, bool useAlpha)
+    : width(rgbImage.width()), height(rgbImage.height()), map((size_t)rgbImage.width() * rgbImage.height(), 0.0)
 {
-    map = std::vector< std::vector<double> >(rgbImage.height(), std::vector<double>(rgbImage.width(), 0.0));
 
     #pragma omp parallel for
     //for every row of the image
@@ -85,47 +87,54 @@ IntensityMap::IntensityMap(const QImage& rgbImage, Mode mode, bool useRed, bool
             }
 
             //add resulting pixel intensity to intensity map
-            this->map.at(y).at(x) = intensity;
+            this->map[(size_t)y * width + x] = intensity;
         }
     }
 }
 
 double IntensityMap::at(int x, int y) const {
-    return this->map.at(y).at(x);
+    return this->map[(size_t)y * width + x];
 }
 
 double IntensityMap::at(int pos) const {
-    const int x = pos % this->getWidth();
-    const int y = pos / this->getWidth();
-
-    return this->at(x, y);
+    return this->map[pos];
 }
 
 void IntensityMap::setValue(int x, int y, double value) {
-    this->map.at(y).at(x) = value;
+    this->map[(size_t)y * width + x] = value;
 }
 
 void IntensityMap::setValue(int pos, double value) {
-    const int x = pos % this->getWidth();
-    const int y = pos / this->getWidth();
-
-    this->map.at(y).at(x) = value;
+    this->map[pos] = value;
 }
 
 size_t IntensityMap::getWidth() const {
-    return this->map.at(0).size();
+    return this->width;
 }
 
 size_t IntensityMap::getHeight() const {
-    return this->map.size();
+    return this->height;
+}
+
+bool IntensityMap::isNull() const {
+    return width == 0 || height == 0;
+}
+
+//null on an empty map
+double* IntensityMap::data() {
+    return this->map.data();
+}
+
+const double* IntensityMap::data() const {
+    return this->map.data();
 }
 
 void IntensityMap::invert() {
     #pragma omp parallel for
     for(int y = 0; y < this->getHeight(); y++) {
         for(int x = 0; x < this->getWidth(); x++) {
-            const double inverted = 1.0 - this->map.at(y).at(x);
-            this->map.at(y).at(x) = inverted;
+            const double inverted = 1.0 - this->at(x, y);
+            this->setValue(x, y, inverted);
         }
     }
 }
@@ -137,7 +146,7 @@ QImage IntensityMap::convertToQImage() const {
         QRgb *scanline = (QRgb*) result.scanLine(y);
 
         for(int x = 0; x < this->getWidth(); x++) {
-            const int c = 255 * map.at(y).at(x);
+            const int c = 255 * this->at(x, y);
             scanline[x] = qRgba(c, c, c, 255);
         }
     }
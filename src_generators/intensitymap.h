@@ -23,6 +23,7 @@
 #define INTENSITYMAP_H
 
 #include <QImage>
+#include "bufferpool.h"
 
 class IntensityMap
 {
@@ -41,11 +42,16 @@ public:
     void setValue(int pos, double value);
     size_t getWidth() const;
     size_t getHeight() const;
+    bool isNull() const;
+    double* data();
+    const double* data() const;
     void invert();
     QImage convertToQImage() const;
 
 private:
-    std::vector< std::vector<double> > map;
+    int width, height;
+    //row after row, the memory is recycled between generations by the BufferPool
+    std::vector< double, PoolAllocator<double> > map;
 };
 
 #endif // INTENSITYMAP_H
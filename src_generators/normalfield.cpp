@@ -0,0 +1,122 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#include "normalfield.h"
+
+NormalField::NormalField()
+    : width(0), height(0)
+{
+}
+
+NormalField::NormalField(int width, int height)
+    : width(width), height(height),
+      nx((size_t)width * height, 0.0f), ny((size_t)width * height, 0.0f), nz((size_t)width * height, 1.0f)
+{
+}
+
+//decodes an 8 bit normalmap (0..255 -> -1..1)
+NormalField::NormalField(const QImage &normalmap)
+    : NormalField(normalmap.width(), normalmap.height())
+{
+    const QImage normalmapARGB = normalmap.convertToFormat(QImage::Format_ARGB32);
+
+    #pragma omp parallel for  // OpenMP
+    for(int y = 0; y < height; y++) {
+        const QRgb *scanline = (const QRgb*) normalmapARGB.constScanLine(y);
+        const size_t row = (size_t)y * width;
+
+        for(int x = 0; x < width; x++) {
+            nx[row + x] = qRed(scanline[x]) / 127.5f - 1.0f;
+            ny[row + x] = qGreen(scanline[x]) / 127.5f - 1.0f;
+            nz[row + x] = qBlue(scanline[x]) / 127.5f - 1.0f;
+        }
+    }
+}
+
+QVector3D NormalField::at(int x, int y) const {
+    const size_t pos = (size_t)y * width + x;
+    return QVector3D(nx[pos], ny[pos], nz[pos]);
+}
+
+void NormalField::setValue(int x, int y, const QVector3D &normal) {
+    const size_t pos = (size_t)y * width + x;
+    nx[pos] = normal.x();
+    ny[pos] = normal.y();
+    nz[pos] = normal.z();
+}
+
+float *NormalField::planeX() {
+    return nx.data();
+}
+
+float *NormalField::planeY() {
+    return ny.data();
+}
+
+float *NormalField::planeZ() {
+    return nz.data();
+}
+
+const float *NormalField::planeX() const {
+    return nx.data();
+}
+
+const float *NormalField::planeY() const {
+    return ny.data();
+}
+
+const float *NormalField::planeZ() const {
+    return nz.data();
+}
+
+size_t NormalField::getWidth() const {
+    return width;
+}
+
+size_t NormalField::getHeight() const {
+    return height;
+}
+
+bool NormalField::isNull() const {
+    return width == 0 || height == 0;
+}
+
+//quantize the normals to an 8 bit normalmap
+QImage NormalField::convertToQImage() const {
+    QImage result(width, height, QImage::Format_ARGB32);
+
+    #pragma omp parallel for  // OpenMP
+    for(int y = 0; y < height; y++) {
+        QRgb *scanline = (QRgb*) result.scanLine(y);
+        const size_t row = (size_t)y * width;
+
+        for(int x = 0; x < width; x++) {
+            scanline[x] = qRgb(mapComponent(nx[row + x]), mapComponent(ny[row + x]), mapComponent(nz[row + x]));
+        }
+    }
+
+    return result;
+}
+
+//transform -1..1 to 0..255
+int NormalField::mapComponent(float value) const {
+    return std::min(std::max((int)((value + 1.0f) * (255.0f / 2.0f)), 0), 255);
+}
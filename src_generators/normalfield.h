@@ -0,0 +1,58 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#ifndef NORMALFIELD_H
+#define NORMALFIELD_H
+
+#include <QImage>
+#include <QVector3D>
+#include "bufferpool.h"
+
+// Floating point normals (-1..1) stored as three separate planes for x, y and z.
+// The generators pass this between each other, the normals are quantized
+// to 8 bit only once when the map is converted to a QImage for export.
+class NormalField
+{
+public:
+    NormalField();
+    NormalField(int width, int height);
+    explicit NormalField(const QImage &normalmap);
+    QVector3D at(int x, int y) const;
+    void setValue(int x, int y, const QVector3D &normal);
+    float *planeX();
+    float *planeY();
+    float *planeZ();
+    const float *planeX() const;
+    const float *planeY() const;
+    const float *planeZ() const;
+    size_t getWidth() const;
+    size_t getHeight() const;
+    bool isNull() const;
+    QImage convertToQImage() const;
+
+private:
+    int width, height;
+    std::vector< float, PoolAllocator<float> > nx, ny, nz;
+
+    int mapComponent(float value) const;
+};
+
+#endif // NORMALFIELD_H
@@ -20,48 +20,227 @@
  ********************************************************************************/
 
 #include "normalmapgenerator.h"
+#include "resampler.h"
+#include "highpassfilter.h"
+#include "guidedfilter.h"
 #include <QVector3D>
 #include <QColor>
+#include <cmath>
+#include <algorithm>
+
+//gradient and z components are kept below this, so the squared length
+//(with FIXED_LENGTH_FRACTION_BITS fractional bits) fits into 32 bit
+static const int FIXED_COMPONENT_LIMIT = 1 << 13;
+static const int FIXED_LENGTH_FRACTION_BITS = 4;
+//the reciprocal square root lookup covers [FIXED_RSQRT_MIN, 4 * FIXED_RSQRT_MIN)
+static const int FIXED_RSQRT_MIN = 1024;
+//fractional bits of the normalized components
+static const int FIXED_RSQRT_BITS = 21;
+//rows per task when the large detail map is computed concurrently
+static const int NORMALMAP_BAND_HEIGHT = 32;
+//the curvature is measured over distances of 1, 2, 4 ... CURVATURE_MAX_SCALE pixels
+static const int CURVATURE_MAX_SCALE = 8;
 
 NormalmapGenerator::NormalmapGenerator(IntensityMap::Mode mode, bool useRed, bool useGreen, bool useBlue, bool useAlpha)
-    : tileable(false), useRed(useRed), useGreen(useGreen), useBlue(useBlue), useAlpha(useAlpha), mode(mode)
+    : tileable(false), useRed(useRed), useGreen(useGreen), useBlue(useBlue), useAlpha(useAlpha), mode(mode), progress(0), highPassRadius(0.0), denoiseRadius(0), denoiseEpsilon(0.0),
+      curvatureEnabled(false), tileMask(0)
 {}
 
 const IntensityMap& NormalmapGenerator::getIntensityMap() const {
     return this->intensity;
 }
 
+//the curvature map of the last calculateNormalField() call if it was enabled
+const IntensityMap& NormalmapGenerator::getCurvatureMap() const {
+    return this->curvature;
+}
+
+//calculateNormalField() also calculates the curvature map from its normals
+void NormalmapGenerator::setCurvatureEnabled(bool enabled) {
+    this->curvatureEnabled = enabled;
+}
+
+//optional, rows are reported to it and it can cancel the calculation
+void NormalmapGenerator::setProgress(GeneratorProgress *progress) {
+    this->progress = progress;
+}
+
+//optional, the normals of the empty tiles are not calculated, they stay flat.
+//The mask has to be made for the size of the input
+void NormalmapGenerator::setTileMask(const TileMask *tileMask) {
+    this->tileMask = (tileMask && !tileMask->isNull()) ? tileMask : 0;
+}
+
+//removes lighting gradients of photos from the height before the normals are calculated:
+//a blurred copy with this radius (standard deviation in pixels) is subtracted, 0 disables it.
+//Only used by the floating point pipeline
+void NormalmapGenerator::setHighPassRadius(double radius) {
+    this->highPassRadius = radius;
+}
+
+//edge preserving smoothing of the height before the normals are calculated (against noise and jpeg artifacts),
+//epsilon is the variance of the intensity (0..1) that still counts as noise. A radius of 0 disables it.
+//Only used by the floating point pipeline
+void NormalmapGenerator::setDenoise(int radius, double epsilon) {
+    this->denoiseRadius = radius;
+    this->denoiseEpsilon = epsilon;
+}
+
 QImage NormalmapGenerator::calculateNormalmap(const QImage& input, Kernel kernel, double strength, bool invert, bool tileable, 
                                               bool keepLargeDetail, int largeDetailScale, double largeDetailHeight) {
+    NormalField normals = calculateNormalField(input, kernel, strength, invert, tileable, keepLargeDetail, largeDetailScale, largeDetailHeight);
+    return normals.convertToQImage();
+}
+
+NormalField NormalmapGenerator::calculateNormalField(const QImage& input, Kernel kernel, double strength, bool invert, bool tileable,
+                                                     bool keepLargeDetail, int largeDetailScale, double largeDetailHeight) {
     this->tileable = tileable;
 
+    // The default "non-inverted" normalmap looks wrong in renderers,
+    // so I use inversion by default
     this->intensity = IntensityMap(input, mode, useRed, useGreen, useBlue, useAlpha);
-    if(!invert) {
-        // The default "non-inverted" normalmap looks wrong in renderers,
-        // so I use inversion by default
-        intensity.invert();
-	}
+    prepareIntensity(intensity, !invert, 1.0);
 
-    QImage result(input.width(), input.height(), QImage::Format_ARGB32);
+    const int width = input.width();
+    const int height = input.height();
+    NormalField result(width, height);
     
     // optimization
     double strengthInv = 1.0 / strength;
 
-    #pragma omp parallel for  // OpenMP
+    if(!keepLargeDetail) {
+        if(progress)
+            progress->addWork(height);
+
+        #pragma omp parallel for  // OpenMP
+        for(int y = 0; y < height; y++) {
+            calculateNormals(intensity, kernel, strengthInv, y, y + 1, tileMask, result);
+        }
+
+        if(curvatureEnabled)
+            curvature = calculateCurvature(result);
+
+        return result;
+    }
+
+    //generate a second normalmap from a downscaled input image, then mix both normalmaps.
+    //The small map is computed by one task while the other threads work on bands of the
+    //full resolution map, each band is blended as soon as both maps are ready for it.
+    int largeDetailMapWidth = std::max((int) (((double)input.width() / 100.0) * largeDetailScale), 1);
+    int largeDetailMapHeight = std::max((int) (((double)input.height() / 100.0) * largeDetailScale), 1);
+    const Resampler resampler(Resampler::BILINEAR, tileable);
+    NormalField largeDetailMap;
+
+    //rows of both normal passes and of the blending
+    if(progress)
+        progress->addWork(height + largeDetailMapHeight + height);
+
+    //the downscaling reads the whole input and the high pass and denoising of the small intensities
+    //are whole image filters. Their parallel loops would be nested (single threaded) inside a task,
+    //so they run before the task graph
+    QImage inputScaled = resampler.scaled(input, largeDetailMapWidth, largeDetailMapHeight);
+    IntensityMap largeDetailIntensity(inputScaled, mode, useRed, useGreen, useBlue, useAlpha);
+    inputScaled = QImage();
+    prepareIntensity(largeDetailIntensity, !invert, (double)largeDetailMapWidth / width);
+
+    //the filter weights of the upscaling are the same for every band
+    const Resampler::Contributions largeDetailColumns = resampler.calculateContributions(largeDetailMapWidth, width);
+    const Resampler::Contributions largeDetailRows = resampler.calculateContributions(largeDetailMapHeight, height);
+
+    const int bandCount = (height + NORMALMAP_BAND_HEIGHT - 1) / NORMALMAP_BAND_HEIGHT;
+    //the first value of a band is its task dependency
+    float *resultX = result.planeX();
+    float *resultY = result.planeY();
+    float *resultZ = result.planeZ();
+
+    #pragma omp parallel  // OpenMP
+    #pragma omp single
+    {
+        #pragma omp task shared(largeDetailMap, largeDetailIntensity) depend(out: largeDetailMap)
+        if(!(progress && progress->isCanceled())) {
+            //compute downscaled normalmap
+            largeDetailMap = NormalField(largeDetailMapWidth, largeDetailMapHeight);
+            calculateNormals(largeDetailIntensity, kernel, 1.0 / largeDetailHeight, 0, largeDetailMapHeight, 0, largeDetailMap);
+        }
+
+        for(int band = 0; band < bandCount; band++) {
+            const int firstRow = band * NORMALMAP_BAND_HEIGHT;
+            const int lastRow = std::min(firstRow + NORMALMAP_BAND_HEIGHT, height);
+            const size_t offset = (size_t)firstRow * width;
+
+            #pragma omp task shared(result) depend(out: resultX[offset])
+            calculateNormals(intensity, kernel, strengthInv, firstRow, lastRow, tileMask, result);
+
+            #pragma omp task shared(largeDetailMap, largeDetailColumns, largeDetailRows) depend(in: resultX[offset], largeDetailMap)
+            if(!(progress && progress->isCanceled())) {
+                //scale the rows of this band up (the normals are not renormalized, like when scaling the 8 bit map)
+                NormalField largeDetailBand(width, lastRow - firstRow);
+                resampler.resampleRows(largeDetailMap.planeX(), largeDetailMapWidth, largeDetailMapHeight, 1,
+                                       largeDetailBand.planeX(), width, firstRow, lastRow, largeDetailColumns, largeDetailRows);
+                resampler.resampleRows(largeDetailMap.planeY(), largeDetailMapWidth, largeDetailMapHeight, 1,
+                                       largeDetailBand.planeY(), width, firstRow, lastRow, largeDetailColumns, largeDetailRows);
+                resampler.resampleRows(largeDetailMap.planeZ(), largeDetailMapWidth, largeDetailMapHeight, 1,
+                                       largeDetailBand.planeZ(), width, firstRow, lastRow, largeDetailColumns, largeDetailRows);
+
+                //mix the normalmaps
+                float *bandX = resultX + offset;
+                float *bandY = resultY + offset;
+                float *bandZ = resultZ + offset;
+                const float *largeDetailX = largeDetailBand.planeX();
+                const float *largeDetailY = largeDetailBand.planeY();
+                const float *largeDetailZ = largeDetailBand.planeZ();
+                const int size = (lastRow - firstRow) * width;
+
+                for(int i = 0; i < size; i++) {
+                    //the empty tiles stay flat
+                    if(tileMask && tileMask->isEmpty(i % width, firstRow + i / width))
+                        continue;
+
+                    bandX[i] = blendSoftLight(bandX[i], largeDetailX[i]);
+                    bandY[i] = blendSoftLight(bandY[i], largeDetailY[i]);
+                    bandZ[i] = blendSoftLight(bandZ[i], largeDetailZ[i]);
+                }
+
+                if(progress)
+                    progress->advance(lastRow - firstRow);
+            }
+        }
+    }
+
+    if(curvatureEnabled)
+        curvature = calculateCurvature(result);
+
+    return result;
+}
+
+//computes the normals of the rows [firstRow, lastRow) from the intensity map, the empty tiles of the mask (optional) are flat
+void NormalmapGenerator::calculateNormals(const IntensityMap& intensityMap, Kernel kernel, double strengthInv,
+                                          int firstRow, int lastRow, const TileMask *mask, NormalField& result) const {
+    const int width = intensityMap.getWidth();
+    const int height = intensityMap.getHeight();
+
     //code from http://stackoverflow.com/a/2368794
-    for(int y = 0; y < input.height(); y++) {
-        QRgb *scanline = (QRgb*) result.scanLine(y);
+    for(int y = firstRow; y < lastRow; y++) {
+        if(progress && progress->isCanceled())
+            return;
 
-        for(int x = 0; x < input.width(); x++) {
+        for(int x = 0; x < width; x++) {
+            if(mask && mask->isEmpty(x, y)) {
+                const int end = mask->emptyRunEnd(x, y, width);
+                for(; x < end; x++)
+                    result.setValue(x, y, QVector3D(0.0f, 0.0f, 1.0f));
+                x--;
+                continue;
+            }
 
-            const double topLeft      = intensity.at(handleEdges(x - 1, input.width()), handleEdges(y - 1, input.height()));
-            const double top          = intensity.at(handleEdges(x - 1, input.width()), handleEdges(y,     input.height()));
-            const double topRight     = intensity.at(handleEdges(x - 1, input.width()), handleEdges(y + 1, input.height()));
-            const double right        = intensity.at(handleEdges(x,     input.width()), handleEdges(y + 1, input.height()));
-            const double bottomRight  = intensity.at(handleEdges(x + 1, input.width()), handleEdges(y + 1, input.height()));
-            const double bottom       = intensity.at(handleEdges(x + 1, input.width()), handleEdges(y,     input.height()));
-            const double bottomLeft   = intensity.at(handleEdges(x + 1, input.width()), handleEdges(y - 1, input.height()));
-            const double left         = intensity.at(handleEdges(x,     input.width()), handleEdges(y - 1, input.height()));
+            const double topLeft      = intensityMap.at(handleEdges(x - 1, width), handleEdges(y - 1, height));
+            const double top          = intensityMap.at(handleEdges(x - 1, width), handleEdges(y,     height));
+            const double topRight     = intensityMap.at(handleEdges(x - 1, width), handleEdges(y + 1, height));
+            const double right        = intensityMap.at(handleEdges(x,     width), handleEdges(y + 1, height));
+            const double bottomRight  = intensityMap.at(handleEdges(x + 1, width), handleEdges(y + 1, height));
+            const double bottom       = intensityMap.at(handleEdges(x + 1, width), handleEdges(y,     height));
+            const double bottomLeft   = intensityMap.at(handleEdges(x + 1, width), handleEdges(y - 1, height));
+            const double left         = intensityMap.at(handleEdges(x,     width), handleEdges(y - 1, height));
 
             const double convolution_kernel[3][3] = {{topLeft, top, topRight},
                                                {left, 0.0, right},
@@ -74,39 +253,181 @@ QImage NormalmapGenerator::calculateNormalmap(const QImage& input, Kernel kernel
             else if(kernel == PREWITT)
                 normal = prewitt(convolution_kernel, strengthInv);
 
-            scanline[x] = qRgb(mapComponent(normal.x()), mapComponent(normal.y()), mapComponent(normal.z()));
+            result.setValue(x, y, normal);
         }
+
+        if(progress)
+            progress->advance();
     }
-    
-    if(keepLargeDetail) {
+}
+
+// Integer version of calculateNormalmap() for 8 bit inputs.
+// Intensities are exact channel sums stored as shorts, the kernel sums are computed in 16 bit on whole rows
+// (so the compiler can pack many pixels into one SIMD register) and the normalization
+// uses 32 bit integers with a reciprocal square root lookup table.
+// The result matches the floating point version within +-1 per channel.
+QImage NormalmapGenerator::calculateNormalmapFixedPoint(const QImage& input, Kernel kernel, double strength, bool invert, bool tileable,
+                                                        bool keepLargeDetail, int largeDetailScale, double largeDetailHeight) {
+    this->tileable = tileable;
+
+    const int width = input.width();
+    const int height = input.height();
+    //the plane has a border of one pixel on every side, so the kernel loops need no edge handling
+    const int stride = width + 2;
+
+    //intensities are not divided by the number of channels, so they stay exact. They are
+    //scaled up to at most 4 * 255, then the kernel sums still fit into a short
+    int numChannels = 1;
+    if(mode == IntensityMap::AVERAGE)
+        numChannels = std::max((useRed ? 1 : 0) + (useGreen ? 1 : 0) + (useBlue ? 1 : 0) + (useAlpha ? 1 : 0), 1);
+    const int intensityScale = 4 / numChannels;
+    const int intensityMax = 255 * numChannels * intensityScale;
+
+    const std::vector< short, PoolAllocator<short> > plane = calculateIntensityFixedPoint(input, invert, intensityScale, intensityMax);
+
+    //the floating point intensity map is still used as depthmap by the SSAO generator
+    this->intensity = IntensityMap(width, height);
+
+    #pragma omp parallel for  // OpenMP
+    for(int y = 0; y < height; y++) {
+        const short *row = &plane[(y + 1) * stride + 1];
+
+        for(int x = 0; x < width; x++) {
+            intensity.setValue(x, y, row[x] / (double)intensityMax);
+        }
+    }
+
+    //z component (1 / strength in intensity units). The normalization is scale invariant,
+    //so if it is too large all components are shifted down instead
+    double dZ = (strength > 0.0) ? intensityMax / strength : 1.0e9;
+    int componentShift = 0;
+    while(dZ >= FIXED_COMPONENT_LIMIT) {
+        dZ /= 2.0;
+        componentShift++;
+    }
+    //dZ is the same for every pixel: its square is precomputed and small values get
+    //fractional bits, otherwise rounding it would be visible at high strength values
+    const unsigned int dZSquared = std::max(1u, (unsigned int)(dZ * dZ * (1 << FIXED_LENGTH_FRACTION_BITS) + 0.5));
+    int dZFractionBits = 0;
+    while(dZ * (1 << (dZFractionBits + 1)) < FIXED_COMPONENT_LIMIT && dZFractionBits < 8) {
+        dZFractionBits++;
+    }
+    const int dZFixed = (int)(dZ * (1 << dZFractionBits) + 0.5);
+
+    const std::vector<int> rsqrtLookup = generateRsqrtLookup();
+    QImage result(width, height, QImage::Format_ARGB32);
+    //color of the empty tiles
+    QRgb flatNormal = 0;
+    normalizeFixedPoint(rsqrtLookup, 0, 0, dZSquared, dZFixed, dZFractionBits, &flatNormal);
+
+    if(progress)
+        progress->addWork(keepLargeDetail ? 2 * height : height);
+
+    #pragma omp parallel  // OpenMP
+    {
+        //gradients of one row
+        std::vector<short> rowDX(width);
+        std::vector<short> rowDY(width);
+
+        #pragma omp for
+        for(int y = 0; y < height; y++) {
+            if(progress && progress->isCanceled())
+                continue;
+
+            QRgb *scanline = (QRgb*) result.scanLine(y);
+            const short *above = &plane[y * stride + 1];
+            const short *center = &plane[(y + 1) * stride + 1];
+            const short *below = &plane[(y + 2) * stride + 1];
+            short *dX = &rowDX[0];
+            short *dY = &rowDY[0];
+
+            //same kernel orientation as in calculateNormalmap(): top/bottom are the
+            //columns x - 1 and x + 1, left/right the rows y - 1 and y + 1
+            if(kernel == SOBEL) {
+                #pragma omp simd
+                for(int x = 0; x < width; x++) {
+                    const short top_side    = above[x - 1] + 2 * center[x - 1] + below[x - 1];
+                    const short bottom_side = above[x + 1] + 2 * center[x + 1] + below[x + 1];
+                    const short right_side  = below[x - 1] + 2 * below[x] + below[x + 1];
+                    const short left_side   = above[x - 1] + 2 * above[x] + above[x + 1];
+
+                    dX[x] = bottom_side - top_side;
+                    dY[x] = right_side - left_side;
+                }
+            }
+            else {
+                #pragma omp simd
+                for(int x = 0; x < width; x++) {
+                    const short top_side    = above[x - 1] + center[x - 1] + below[x - 1];
+                    const short bottom_side = above[x + 1] + center[x + 1] + below[x + 1];
+                    const short right_side  = below[x - 1] + below[x] + below[x + 1];
+                    const short left_side   = above[x - 1] + above[x] + above[x + 1];
+
+                    dX[x] = top_side - bottom_side;
+                    dY[x] = right_side - left_side;
+                }
+            }
+
+            for(int x = 0; x < width; x++) {
+                if(tileMask && tileMask->isEmpty(x, y)) {
+                    const int end = tileMask->emptyRunEnd(x, y, width);
+                    std::fill(scanline + x, scanline + end, flatNormal);
+                    x = end - 1;
+                    continue;
+                }
+
+                normalizeFixedPoint(rsqrtLookup, dX[x] >> componentShift, dY[x] >> componentShift,
+                                    dZSquared, dZFixed, dZFractionBits, &scanline[x]);
+            }
+
+            if(progress)
+                progress->advance();
+        }
+    }
+
+    if(keepLargeDetail && !(progress && progress->isCanceled())) {
         //generate a second normalmap from a downscaled input image, then mix both normalmaps
-        
+
         int largeDetailMapWidth = (int) (((double)input.width() / 100.0) * largeDetailScale);
         int largeDetailMapHeight = (int) (((double)input.height() / 100.0) * largeDetailScale);
-        
+
         //create downscaled version of input
-        QImage inputScaled = input.scaled(largeDetailMapWidth, largeDetailMapHeight, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-        //compute downscaled normalmap
-        QImage largeDetailMap = calculateNormalmap(inputScaled, kernel, largeDetailHeight, invert, tileable, false, 0, 0.0);
+        const Resampler resampler(Resampler::BILINEAR, tileable);
+        QImage inputScaled = resampler.scaled(input, largeDetailMapWidth, largeDetailMapHeight);
+        //compute downscaled normalmap (the tile mask is made for the full size)
+        const TileMask *fullSizeMask = tileMask;
+        tileMask = 0;
+        QImage largeDetailMap = calculateNormalmapFixedPoint(inputScaled, kernel, largeDetailHeight, invert, tileable, false, 0, 0.0);
+        tileMask = fullSizeMask;
         //scale map up
-        largeDetailMap = largeDetailMap.scaled(input.width(), input.height(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-        
+        largeDetailMap = resampler.scaled(largeDetailMap, input.width(), input.height());
+
         #pragma omp parallel for  // OpenMP
         //mix the normalmaps
         for(int y = 0; y < input.height(); y++) {
+            if(progress && progress->isCanceled())
+                continue;
+
             QRgb *scanlineResult = (QRgb*) result.scanLine(y);
             QRgb *scanlineLargeDetail = (QRgb*) largeDetailMap.scanLine(y);
 
             for(int x = 0; x < input.width(); x++) {
+                //the empty tiles stay flat
+                if(tileMask && tileMask->isEmpty(x, y))
+                    continue;
+
                 const QRgb colorResult = scanlineResult[x];
                 const QRgb colorLargeDetail = scanlineLargeDetail[x];
 
-                const int r = blendSoftLight(qRed(colorResult), qRed(colorLargeDetail));
-                const int g = blendSoftLight(qGreen(colorResult), qGreen(colorLargeDetail));
-                const int b = blendSoftLight(qBlue(colorResult), qBlue(colorLargeDetail));
+                const int r = blendSoftLightFixedPoint(qRed(colorResult), qRed(colorLargeDetail));
+                const int g = blendSoftLightFixedPoint(qGreen(colorResult), qGreen(colorLargeDetail));
+                const int b = blendSoftLightFixedPoint(qBlue(colorResult), qBlue(colorLargeDetail));
 
                 scanlineResult[x] = qRgb(r, g, b);
             }
+
+            if(progress)
+                progress->advance();
         }
     }
 
@@ -139,18 +460,93 @@ QVector3D NormalmapGenerator::prewitt(const double convolution_kernel[3][3], dou
     return QVector3D(dX, dY, dZ).normalized();
 }
 
+//convexity (bright) and concavity (dark) as the divergence of the normals, 0.5 is flat.
+//The change of the normals is measured over several distances and averaged, so both
+//sharp edges and broad curves show up. One stencil pass over the normal planes
+IntensityMap NormalmapGenerator::calculateCurvature(const NormalField &normals) const {
+    const int width = normals.getWidth();
+    const int height = normals.getHeight();
+    IntensityMap result(width, height);
+    if(width == 0 || height == 0)
+        return result;
+
+    if(progress)
+        progress->addWork(height);
+
+    const float *nx = normals.planeX();
+    const float *ny = normals.planeY();
+    double *resultData = result.data();
+
+    int scales = 0;
+    for(int scale = 1; scale <= CURVATURE_MAX_SCALE; scale *= 2)
+        scales++;
+
+    #pragma omp parallel for  // OpenMP
+    for(int y = 0; y < height; y++) {
+        if(progress && progress->isCanceled())
+            continue;
+
+        double *row = resultData + (size_t)y * width;
+        std::fill(row, row + width, 0.0);
+
+        for(int scale = 1; scale <= CURVATURE_MAX_SCALE; scale *= 2) {
+            const float *rowAbove = ny + (size_t)handleEdges(y - scale, height) * width;
+            const float *rowBelow = ny + (size_t)handleEdges(y + scale, height) * width;
+            const float *rowX = nx + (size_t)y * width;
+            //central differences over 2 * scale pixels, as change per pixel
+            const float distanceInv = 1.0f / (2 * scale);
+
+            for(int x = 0; x < width; x++) {
+                const float changeX = rowX[handleEdges(x + scale, width)] - rowX[handleEdges(x - scale, width)];
+                const float changeY = rowBelow[x] - rowAbove[x];
+                row[x] += (changeX + changeY) * distanceInv;
+            }
+        }
+
+        //divergence of the normals averaged over the scales, -1..1 is mapped to 0..1
+        for(int x = 0; x < width; x++) {
+            const double value = 0.5 + 0.5 * row[x] / scales;
+            row[x] = std::min(std::max(value, 0.0), 1.0);
+        }
+
+        if(progress)
+            progress->advance();
+    }
+
+    return result;
+}
+
+//denoising, then inversion and high pass in one pass over the map.
+//scale: size of the map relative to the input, the filter radii are given for the input
+void NormalmapGenerator::prepareIntensity(IntensityMap &intensityMap, bool invert, double scale) const {
+    if(denoiseRadius > 0) {
+        GuidedFilter denoise;
+        denoise.setProgress(progress);
+        denoise.apply(intensityMap, std::max((int)std::lround(denoiseRadius * scale), 1), denoiseEpsilon, tileable);
+    }
+
+    if(highPassRadius > 0.0) {
+        HighPassFilter highPass;
+        highPass.setProgress(progress);
+        highPass.apply(intensityMap, highPassRadius * scale, tileable, invert);
+    }
+    else if(invert) {
+        intensityMap.invert();
+    }
+}
+
 int NormalmapGenerator::handleEdges(int iterator, int maxValue) const {
     if(iterator >= maxValue) {
         //move iterator from end to beginning + overhead
         if(tileable)
-            return maxValue - iterator;
+            return iterator % maxValue;
         else
             return maxValue - 1;
     }
     else if(iterator < 0) {
         //move iterator from beginning to end - overhead
         if(tileable)
-            return maxValue + iterator;
+            return (iterator % maxValue + maxValue) % maxValue;
         else
             return 0;
     }
@@ -159,21 +555,133 @@ int NormalmapGenerator::handleEdges(int iterator, int maxValue) const {
     }
 }
 
-//transform -1..1 to 0..255
-int NormalmapGenerator::mapComponent(double value) const {
-    return (value + 1.0) * (255.0 / 2.0);
-}
-
 //uses a similar algorithm like "soft light" in PS, 
 //see http://www.michael-kreil.de/algorithmen/photoshop-layer-blending-equations/index.php
-int NormalmapGenerator::blendSoftLight(int color1, int color2) const {
-    const float a = color1;
-    const float b = color2;
+//the normal components are blended in the 0..1 range of the encoded normalmap
+float NormalmapGenerator::blendSoftLight(float normal1, float normal2) const {
+    const float a = (normal1 + 1.0f) * 0.5f;
+    const float b = (normal2 + 1.0f) * 0.5f;
+    float blended;
     
-    if(2.0f * b < 255.0f) {
-        return (int) (((a + 127.5f) * b) / 255.0f);
+    if(2.0f * b < 1.0f) {
+        blended = (a + 0.5f) * b;
+    }
+    else {
+        blended = 1.0f - (1.5f - a) * (1.0f - b);
+    }
+
+    return blended * 2.0f - 1.0f;
+}
+
+//builds the intensity plane of the integer pipeline (scaled channel sums, 0..intensityMax) with a
+//border of one pixel on every side that is filled like handleEdges() would (wrap around or repeat the edge)
+std::vector< short, PoolAllocator<short> > NormalmapGenerator::calculateIntensityFixedPoint(const QImage& input, bool invert, int intensityScale, int intensityMax) const {
+    const int width = input.width();
+    const int height = input.height();
+    const int stride = width + 2;
+    std::vector< short, PoolAllocator<short> > plane(stride * (height + 2), 0);
+
+    const QImage inputARGB = input.convertToFormat(QImage::Format_ARGB32);
+
+    #pragma omp parallel for  // OpenMP
+    for(int y = 0; y < height; y++) {
+        const QRgb *scanline = (const QRgb*) inputARGB.constScanLine(y);
+        short *row = &plane[(y + 1) * stride + 1];
+
+        for(int x = 0; x < width; x++) {
+            const unsigned int r = useRed ? qRed(scanline[x]) : 0;
+            const unsigned int g = useGreen ? qGreen(scanline[x]) : 0;
+            const unsigned int b = useBlue ? qBlue(scanline[x]) : 0;
+            const unsigned int a = useAlpha ? qAlpha(scanline[x]) : 0;
+
+            unsigned int value = 0;
+            if(mode == IntensityMap::AVERAGE)
+                value = r + g + b + a;
+            else if(mode == IntensityMap::MAX)
+                value = std::max(std::max(r, g), std::max(b, a));
+
+            value *= intensityScale;
+
+            //same as in calculateNormalmap(): inverted by default
+            row[x] = invert ? value : intensityMax - value;
+        }
+    }
+
+    //left and right border
+    for(int y = 1; y <= height; y++) {
+        short *row = &plane[y * stride];
+        row[0] = row[tileable ? width : 1];
+        row[width + 1] = row[tileable ? 1 : width];
+    }
+
+    //top and bottom border (including the corners)
+    const int sourceTop = tileable ? height : 1;
+    const int sourceBottom = tileable ? 1 : height;
+    std::copy(plane.begin() + sourceTop * stride, plane.begin() + (sourceTop + 1) * stride, plane.begin());
+    std::copy(plane.begin() + sourceBottom * stride, plane.begin() + (sourceBottom + 1) * stride,
+              plane.begin() + (height + 1) * stride);
+
+    return plane;
+}
+
+//normalizes (dX, dY, dZ) and maps it to 0..255 like mapComponent().
+//dX and dY have to be smaller than FIXED_COMPONENT_LIMIT, dZ is given as its square (with
+//FIXED_LENGTH_FRACTION_BITS fractional bits) and as a fixed-point value with dZFractionBits fractional bits
+void NormalmapGenerator::normalizeFixedPoint(const std::vector<int>& rsqrtLookup, int dX, int dY,
+                                             unsigned int dZSquared, int dZFixed, int dZFractionBits, QRgb *pixel) const {
+    unsigned int lengthSquared = ((dX * dX + dY * dY) << FIXED_LENGTH_FRACTION_BITS) + dZSquared;
+
+    //bring the squared length into the range of the lookup table in steps of 4,
+    //then the square root of the scale factor is a power of two
+    int shift = -FIXED_LENGTH_FRACTION_BITS / 2;
+    while(lengthSquared >= 4 * FIXED_RSQRT_MIN) {
+        lengthSquared >>= 2;
+        shift++;
+    }
+    while(lengthSquared < FIXED_RSQRT_MIN) {
+        lengthSquared <<= 2;
+        shift--;
+    }
+
+    const int rsqrt = rsqrtLookup[lengthSquared - FIXED_RSQRT_MIN];
+    const int components[3] = {dX, dY, dZFixed};
+    const int fractionBits[3] = {0, 0, dZFractionBits};
+    int mapped[3];
+
+    for(int i = 0; i < 3; i++) {
+        //normalized component with FIXED_RSQRT_BITS fractional bits
+        int value = components[i] * rsqrt;
+        const int totalShift = shift + fractionBits[i];
+        if(totalShift >= 0)
+            value >>= totalShift;
+        else
+            value *= 1 << -totalShift;
+
+        //transform -1..1 to 0..255
+        const int component = ((value + (1 << FIXED_RSQRT_BITS)) * 255) >> (FIXED_RSQRT_BITS + 1);
+        mapped[i] = std::min(std::max(component, 0), 255);
+    }
+
+    *pixel = qRgb(mapped[0], mapped[1], mapped[2]);
+}
+
+//1 / sqrt(i) with FIXED_RSQRT_BITS fractional bits for i in [FIXED_RSQRT_MIN, 4 * FIXED_RSQRT_MIN)
+std::vector<int> NormalmapGenerator::generateRsqrtLookup() const {
+    std::vector<int> lookup(3 * FIXED_RSQRT_MIN);
+
+    for(int i = 0; i < 3 * FIXED_RSQRT_MIN; i++) {
+        lookup[i] = (int)((1 << FIXED_RSQRT_BITS) / sqrt((double)(i + FIXED_RSQRT_MIN)) + 0.5);
+    }
+
+    return lookup;
+}
+
+//integer version of blendSoftLight() for 8 bit values, rounds exactly like the float version did
+int NormalmapGenerator::blendSoftLightFixedPoint(int color1, int color2) const {
+    if(2 * color2 < 255) {
+        return ((2 * color1 + 255) * color2) / 510;
     }
     else {
-        return (int) (255.0f - (((382.5f - a) * (255.0f - b)) / 255.0f));
+        return 255 - ((765 - 2 * color1) * (255 - color2) + 509) / 510;
     }
 }
@@ -24,6 +24,9 @@
 
 #include <QImage>
 #include "intensitymap.h"
+#include "normalfield.h"
+#include "generatorprogress.h"
+#include "tilemask.h"
 
 class NormalmapGenerator
 {
@@ -37,19 +40,48 @@ public:
     QImage calculateNormalmap(const QImage& input, Kernel kernel, double strength = 2.0, bool invert = false, 
                               bool tileable = true, bool keepLargeDetail = true,
                               int largeDetailScale = 25, double largeDetailHeight = 1.0);
+    NormalField calculateNormalField(const QImage& input, Kernel kernel, double strength = 2.0, bool invert = false,
+                                     bool tileable = true, bool keepLargeDetail = true,
+                                     int largeDetailScale = 25, double largeDetailHeight = 1.0);
+    QImage calculateNormalmapFixedPoint(const QImage& input, Kernel kernel, double strength = 2.0, bool invert = false,
+                                        bool tileable = true, bool keepLargeDetail = true,
+                                        int largeDetailScale = 25, double largeDetailHeight = 1.0);
     const IntensityMap& getIntensityMap() const;
+    IntensityMap calculateCurvature(const NormalField &normals) const;
+    const IntensityMap& getCurvatureMap() const;
+    void setCurvatureEnabled(bool enabled);
+    void setProgress(GeneratorProgress *progress);
+    void setHighPassRadius(double radius);
+    void setDenoise(int radius, double epsilon);
+    void setTileMask(const TileMask *tileMask);
 
 private:
     IntensityMap intensity;
     bool tileable;
     bool useRed, useGreen, useBlue, useAlpha;
     IntensityMap::Mode mode;
+    GeneratorProgress *progress;
+    double highPassRadius;
+    int denoiseRadius;
+    double denoiseEpsilon;
+    IntensityMap curvature;
+    bool curvatureEnabled;
+    const TileMask *tileMask;
 
+    void prepareIntensity(IntensityMap &intensityMap, bool invert, double scale) const;
     int handleEdges(int iterator, int maxValue) const;
-    int mapComponent(double value) const;
+    void calculateNormals(const IntensityMap& intensityMap, Kernel kernel, double strengthInv,
+                          int firstRow, int lastRow, const TileMask *mask, NormalField& result) const;
     QVector3D sobel(const double convolution_kernel[3][3], double strengthInv) const;
     QVector3D prewitt(const double convolution_kernel[3][3], double strengthInv) const;
-    int blendSoftLight(int color1, int color2) const;
+    float blendSoftLight(float normal1, float normal2) const;
+
+    //8 bit integer pipeline
+    std::vector< short, PoolAllocator<short> > calculateIntensityFixedPoint(const QImage& input, bool invert, int intensityScale, int intensityMax) const;
+    void normalizeFixedPoint(const std::vector<int>& rsqrtLookup, int dX, int dY,
+                             unsigned int dZSquared, int dZFixed, int dZFractionBits, QRgb *pixel) const;
+    std::vector<int> generateRsqrtLookup() const;
+    int blendSoftLightFixedPoint(int color1, int color2) const;
 };
 
 #endif // SOBEL_H
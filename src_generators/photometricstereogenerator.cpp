@@ -0,0 +1,233 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#include "photometricstereogenerator.h"
+#include "resampler.h"
+#include <cmath>
+
+//rows solved together by one thread
+static const int PHOTOMETRICSTEREO_TILE_HEIGHT = 32;
+//the determinant of L^T L relative to the light count cubed, below this the lights are (nearly) coplanar
+static const double PHOTOMETRICSTEREO_MIN_DETERMINANT = 1.0e-6;
+
+PhotometricStereoGenerator::PhotometricStereoGenerator()
+    : progress(0)
+{
+}
+
+//optional, loaded images and solved rows are reported to it and it can cancel the calculation
+void PhotometricStereoGenerator::setProgress(GeneratorProgress *progress) {
+    this->progress = progress;
+}
+
+//the albedo of the last calculation, 0..1
+const IntensityMap& PhotometricStereoGenerator::getAlbedo() const {
+    return albedo;
+}
+
+NormalField PhotometricStereoGenerator::calculateNormalField(const QStringList &imagePaths, const std::vector<QVector3D> &lightDirections) {
+    albedo = IntensityMap();
+
+    if(imagePaths.size() < 3 || (size_t)imagePaths.size() != lightDirections.size())
+        return NormalField();
+
+    //the normal equations only depend on the lights, invert them once for all pixels
+    float inverse[9];
+    if(!invertLightMatrix(lightDirections, inverse))
+        return NormalField();
+
+    //only L^T I is accumulated, so just one image is in memory at a time
+    Buffer sumX, sumY, sumZ;
+    int width = 0;
+    int height = 0;
+
+    for(int i = 0; i < imagePaths.size(); i++) {
+        if(progress && progress->isCanceled())
+            return NormalField();
+
+        QImage image(imagePaths.at(i));
+        if(image.isNull())
+            return NormalField();
+
+        if(i == 0) {
+            width = image.width();
+            height = image.height();
+            sumX.assign((size_t)width * height, 0.0f);
+            sumY.assign((size_t)width * height, 0.0f);
+            sumZ.assign((size_t)width * height, 0.0f);
+
+            if(progress)
+                progress->addWork((long long)height * (imagePaths.size() + 1));
+        }
+        else if(image.width() != width || image.height() != height) {
+            return NormalField();
+        }
+
+        accumulate(image, lightDirections.at(i).normalized(), sumX, sumY, sumZ);
+    }
+
+    NormalField result(width, height);
+    albedo = IntensityMap(width, height);
+    solve(inverse, sumX, sumY, sumZ, result);
+
+    if(progress && progress->isCanceled())
+        return NormalField();
+
+    return result;
+}
+
+//inverse of the 3x3 matrix L^T L, L has one normalized light direction per row
+bool PhotometricStereoGenerator::invertLightMatrix(const std::vector<QVector3D> &lightDirections, float inverse[9]) const {
+    double m[3][3] = {{0.0}};
+
+    for(size_t i = 0; i < lightDirections.size(); i++) {
+        const QVector3D l = lightDirections.at(i).normalized();
+        const double components[3] = {l.x(), l.y(), l.z()};
+
+        for(int row = 0; row < 3; row++) {
+            for(int column = 0; column < 3; column++) {
+                m[row][column] += components[row] * components[column];
+            }
+        }
+    }
+
+    //cofactors (the matrix is symmetric, so is its inverse)
+    const double c00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+    const double c01 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+    const double c02 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+    const double det = m[0][0] * c00 + m[0][1] * c01 + m[0][2] * c02;
+
+    const double count = (double)lightDirections.size();
+    if(std::abs(det) < PHOTOMETRICSTEREO_MIN_DETERMINANT * count * count * count)
+        return false;
+
+    const double invDet = 1.0 / det;
+    inverse[0] = c00 * invDet;
+    inverse[1] = c01 * invDet;
+    inverse[2] = c02 * invDet;
+    inverse[3] = inverse[1];
+    inverse[4] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * invDet;
+    inverse[5] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * invDet;
+    inverse[6] = inverse[2];
+    inverse[7] = inverse[5];
+    inverse[8] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * invDet;
+
+    return true;
+}
+
+//adds the intensity of the image (average of r, g and b) times the light direction
+void PhotometricStereoGenerator::accumulate(const QImage &image, const QVector3D &light, Buffer &sumX, Buffer &sumY, Buffer &sumZ) const {
+    //16 bit and 10 bit photos are read with 16 bits per channel, 8 bit ones as RGB32
+    bool sixteenBit = false;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+    sixteenBit = Resampler::moreThan8BitsPerChannel(image);
+    const QImage rgbImage = image.convertToFormat(sixteenBit ? QImage::Format_RGBX64 : QImage::Format_RGB32);
+#else
+    const QImage rgbImage = image.convertToFormat(QImage::Format_RGB32);
+#endif
+    const int width = rgbImage.width();
+    const int height = rgbImage.height();
+    const float scale = 1.0f / (3.0f * (sixteenBit ? 65535.0f : 255.0f));
+    const float lx = light.x();
+    const float ly = light.y();
+    const float lz = light.z();
+
+    #pragma omp parallel for  // OpenMP
+    for(int y = 0; y < height; y++) {
+        if(progress && progress->isCanceled())
+            continue;
+
+        float *rowX = &sumX[(size_t)y * width];
+        float *rowY = &sumY[(size_t)y * width];
+        float *rowZ = &sumZ[(size_t)y * width];
+
+        if(sixteenBit) {
+            //r, g, b, x in memory order
+            const quint16 *scanline = reinterpret_cast<const quint16*>(rgbImage.constScanLine(y));
+
+            for(int x = 0; x < width; x++) {
+                const quint16 *pixel = scanline + 4 * x;
+                const float intensity = ((float)pixel[0] + pixel[1] + pixel[2]) * scale;
+                rowX[x] += intensity * lx;
+                rowY[x] += intensity * ly;
+                rowZ[x] += intensity * lz;
+            }
+        }
+        else {
+            const QRgb *scanline = reinterpret_cast<const QRgb*>(rgbImage.constScanLine(y));
+
+            for(int x = 0; x < width; x++) {
+                const QRgb pixel = scanline[x];
+                const float intensity = (qRed(pixel) + qGreen(pixel) + qBlue(pixel)) * scale;
+                rowX[x] += intensity * lx;
+                rowY[x] += intensity * ly;
+                rowZ[x] += intensity * lz;
+            }
+        }
+
+        if(progress)
+            progress->advance();
+    }
+}
+
+//g = (L^T L)^-1 L^T I, the length of g is the albedo and its direction the normal
+void PhotometricStereoGenerator::solve(const float inverse[9], const Buffer &sumX, const Buffer &sumY, const Buffer &sumZ, NormalField &result) {
+    const int width = result.getWidth();
+    const int height = result.getHeight();
+    const int tiles = (height + PHOTOMETRICSTEREO_TILE_HEIGHT - 1) / PHOTOMETRICSTEREO_TILE_HEIGHT;
+    float *nx = result.planeX();
+    float *ny = result.planeY();
+    float *nz = result.planeZ();
+    double *albedoData = albedo.data();
+
+    #pragma omp parallel for  // OpenMP
+    for(int tile = 0; tile < tiles; tile++) {
+        if(progress && progress->isCanceled())
+            continue;
+
+        const int firstRow = tile * PHOTOMETRICSTEREO_TILE_HEIGHT;
+        const int lastRow = std::min(firstRow + PHOTOMETRICSTEREO_TILE_HEIGHT, height);
+        const size_t begin = (size_t)firstRow * width;
+        const size_t end = (size_t)lastRow * width;
+
+        #pragma omp simd
+        for(size_t i = begin; i < end; i++) {
+            const float bx = sumX[i];
+            const float by = sumY[i];
+            const float bz = sumZ[i];
+            const float gx = inverse[0] * bx + inverse[1] * by + inverse[2] * bz;
+            const float gy = inverse[3] * bx + inverse[4] * by + inverse[5] * bz;
+            const float gz = inverse[6] * bx + inverse[7] * by + inverse[8] * bz;
+            const float length = std::sqrt(gx * gx + gy * gy + gz * gz);
+
+            //pixels that are black in every photo get a flat normal
+            const bool valid = length > 1.0e-6f;
+            const float invLength = valid ? 1.0f / length : 0.0f;
+            nx[i] = gx * invLength;
+            ny[i] = gy * invLength;
+            nz[i] = valid ? gz * invLength : 1.0f;
+            albedoData[i] = std::min(length, 1.0f);
+        }
+
+        if(progress)
+            progress->advance(lastRow - firstRow);
+    }
+}
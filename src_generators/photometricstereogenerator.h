@@ -0,0 +1,58 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#ifndef PHOTOMETRICSTEREOGENERATOR_H
+#define PHOTOMETRICSTEREOGENERATOR_H
+
+#include <QStringList>
+#include <QVector3D>
+#include <vector>
+#include "intensitymap.h"
+#include "normalfield.h"
+#include "generatorprogress.h"
+
+// Reconstructs normals and albedo from several photos of the same surface, each lit
+// from a different known direction. Per pixel the lambertian model I = albedo * dot(n, l)
+// is solved in the least squares sense: (L^T L) g = L^T I with g = albedo * n.
+// The light directions use the normalmap frame: x to the right, y down the image rows,
+// z towards the camera.
+class PhotometricStereoGenerator
+{
+public:
+    PhotometricStereoGenerator();
+    //returns a null field if fewer than 3 lights are given, the lights lie in one plane,
+    //an image can't be loaded or the image sizes differ
+    NormalField calculateNormalField(const QStringList &imagePaths, const std::vector<QVector3D> &lightDirections);
+    const IntensityMap& getAlbedo() const;
+    void setProgress(GeneratorProgress *progress);
+
+private:
+    typedef std::vector< float, PoolAllocator<float> > Buffer;
+
+    IntensityMap albedo;
+    GeneratorProgress *progress;
+
+    bool invertLightMatrix(const std::vector<QVector3D> &lightDirections, float inverse[9]) const;
+    void accumulate(const QImage &image, const QVector3D &light, Buffer &sumX, Buffer &sumY, Buffer &sumZ) const;
+    void solve(const float inverse[9], const Buffer &sumX, const Buffer &sumY, const Buffer &sumZ, NormalField &result);
+};
+
+#endif // PHOTOMETRICSTEREOGENERATOR_H
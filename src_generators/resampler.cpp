@@ -0,0 +1,407 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#include "resampler.h"
+#include <cmath>
+
+Resampler::Resampler(Filter filter, bool tileable)
+    : filter(filter), tileable(tileable)
+{
+}
+
+QImage Resampler::scaled(const QImage &image, int width, int height) const {
+    if(image.isNull() || width <= 0 || height <= 0)
+        return QImage();
+
+    const int inputWidth = image.width();
+    const int inputHeight = image.height();
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 13, 0)
+    //16 bit height maps stay 16 bit grayscale, with a single channel
+    if(image.format() == QImage::Format_Grayscale16) {
+        std::vector< float, PoolAllocator<float> > input((size_t)inputWidth * inputHeight);
+        std::vector< float, PoolAllocator<float> > output((size_t)width * height);
+
+        #pragma omp parallel for  // OpenMP
+        for(int y = 0; y < inputHeight; y++) {
+            const quint16 *scanline = (const quint16*) image.constScanLine(y);
+            float *row = &input[(size_t)y * inputWidth];
+
+            for(int x = 0; x < inputWidth; x++) {
+                row[x] = scanline[x];
+            }
+        }
+
+        resample(&input[0], inputWidth, inputHeight, 1, &output[0], width, height);
+
+        QImage result(width, height, QImage::Format_Grayscale16);
+
+        #pragma omp parallel for  // OpenMP
+        for(int y = 0; y < height; y++) {
+            quint16 *scanline = (quint16*) result.scanLine(y);
+            const float *row = &output[(size_t)y * width];
+
+            for(int x = 0; x < width; x++) {
+                scanline[x] = (quint16)std::min(std::max(row[x] + 0.5f, 0.0f), 65535.0f);
+            }
+        }
+
+        return result;
+    }
+#endif
+
+    const size_t inputSize = (size_t)inputWidth * inputHeight * 4;
+    const size_t outputSize = (size_t)width * height * 4;
+
+    std::vector< float, PoolAllocator<float> > inputChannels(inputSize);
+    std::vector< float, PoolAllocator<float> > outputChannels(outputSize);
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+    //keep images with more than 8 bits per channel (16 bit and 10 bit formats) in 16 bit
+    if(moreThan8BitsPerChannel(image)) {
+        const QImage premultiplied = image.convertToFormat(QImage::Format_RGBA64_Premultiplied);
+
+        #pragma omp parallel for  // OpenMP
+        for(int y = 0; y < inputHeight; y++) {
+            const quint16 *scanline = (const quint16*) premultiplied.constScanLine(y);
+            float *row = &inputChannels[(size_t)y * inputWidth * 4];
+
+            for(int i = 0; i < inputWidth * 4; i++) {
+                row[i] = scanline[i];
+            }
+        }
+
+        resample(&inputChannels[0], inputWidth, inputHeight, 4, &outputChannels[0], width, height);
+
+        QImage result(width, height, QImage::Format_RGBA64_Premultiplied);
+
+        #pragma omp parallel for  // OpenMP
+        for(int y = 0; y < height; y++) {
+            quint16 *scanline = (quint16*) result.scanLine(y);
+            const float *row = &outputChannels[(size_t)y * width * 4];
+
+            for(int i = 0; i < width * 4; i++) {
+                scanline[i] = (quint16)std::min(std::max(row[i] + 0.5f, 0.0f), 65535.0f);
+            }
+        }
+
+        return result.convertToFormat(QImage::Format_RGBA64);
+    }
+#endif
+
+    //8 bit per channel, premultiplied so transparent pixels do not bleed into their neighbours
+    const QImage premultiplied = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+    #pragma omp parallel for  // OpenMP
+    for(int y = 0; y < inputHeight; y++) {
+        const uchar *scanline = premultiplied.constScanLine(y);
+        float *row = &inputChannels[(size_t)y * inputWidth * 4];
+
+        for(int i = 0; i < inputWidth * 4; i++) {
+            row[i] = scanline[i];
+        }
+    }
+
+    resample(&inputChannels[0], inputWidth, inputHeight, 4, &outputChannels[0], width, height);
+
+    QImage result(width, height, QImage::Format_ARGB32_Premultiplied);
+    //byte order of a QRgb in memory: B, G, R, A on little endian, A, R, G, B on big endian
+    const int alphaOffset = QSysInfo::ByteOrder == QSysInfo::LittleEndian ? 3 : 0;
+
+    #pragma omp parallel for  // OpenMP
+    for(int y = 0; y < height; y++) {
+        uchar *scanline = result.scanLine(y);
+        const float *row = &outputChannels[(size_t)y * width * 4];
+
+        for(int x = 0; x < width; x++) {
+            //the filters can overshoot, a color channel must not become larger than alpha
+            const float alpha = std::min(std::max(row[x * 4 + alphaOffset], 0.0f), 255.0f);
+
+            for(int c = 0; c < 4; c++) {
+                scanline[x * 4 + c] = (uchar)(std::min(std::max(row[x * 4 + c], 0.0f), alpha) + 0.5f);
+            }
+        }
+    }
+
+    return result.convertToFormat(QImage::Format_ARGB32);
+}
+
+//formats that lose precision when they are converted to ARGB32
+bool Resampler::moreThan8BitsPerChannel(const QImage &image) {
+    switch(image.format()) {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+    case QImage::Format_RGBX64:
+    case QImage::Format_RGBA64:
+    case QImage::Format_RGBA64_Premultiplied:
+#endif
+#if QT_VERSION >= QT_VERSION_CHECK(5, 13, 0)
+    case QImage::Format_Grayscale16:
+#endif
+    case QImage::Format_BGR30:
+    case QImage::Format_A2BGR30_Premultiplied:
+    case QImage::Format_RGB30:
+    case QImage::Format_A2RGB30_Premultiplied:
+        return true;
+    default:
+        return false;
+    }
+}
+
+IntensityMap Resampler::scaled(const IntensityMap &map, int width, int height) const {
+    IntensityMap result(width, height);
+    resample(map.data(), map.getWidth(), map.getHeight(), 1, result.data(), width, height);
+    return result;
+}
+
+NormalField Resampler::scaled(const NormalField &field, int width, int height) const {
+    NormalField result(width, height);
+    resample(field.planeX(), field.getWidth(), field.getHeight(), 1, result.planeX(), width, height);
+    resample(field.planeY(), field.getWidth(), field.getHeight(), 1, result.planeY(), width, height);
+    resample(field.planeZ(), field.getWidth(), field.getHeight(), 1, result.planeZ(), width, height);
+    return result;
+}
+
+// Scales an image with interleaved channels, first horizontally into a temporary buffer, then vertically.
+// Both passes are parallelized over the rows.
+template<typename T>
+void Resampler::resample(const T *input, int inputWidth, int inputHeight, int channels,
+                         T *output, int outputWidth, int outputHeight) const {
+    const Contributions horizontal = calculateContributions(inputWidth, outputWidth);
+    const Contributions vertical = calculateContributions(inputHeight, outputHeight);
+
+    const int inputRowSize = inputWidth * channels;
+    const int outputRowSize = outputWidth * channels;
+    std::vector< T, PoolAllocator<T> > temp((size_t)outputRowSize * inputHeight);
+
+    #pragma omp parallel for  // OpenMP
+    for(int y = 0; y < inputHeight; y++) {
+        scaleRow(&input[(size_t)y * inputRowSize], horizontal, channels, outputWidth, &temp[(size_t)y * outputRowSize]);
+    }
+
+    #pragma omp parallel for  // OpenMP
+    for(int y = 0; y < outputHeight; y++) {
+        const int *indices = &vertical.indices[(size_t)y * vertical.taps];
+        const float *weights = &vertical.weights[(size_t)y * vertical.taps];
+        T *outputRow = &output[(size_t)y * outputRowSize];
+
+        for(int i = 0; i < outputRowSize; i++) {
+            outputRow[i] = 0;
+        }
+
+        //add whole weighted rows, this is contiguous in memory
+        for(int t = 0; t < vertical.taps; t++) {
+            const T *tempRow = &temp[(size_t)indices[t] * outputRowSize];
+            const T w = weights[t];
+
+            for(int i = 0; i < outputRowSize; i++) {
+                outputRow[i] += w * tempRow[i];
+            }
+        }
+    }
+}
+
+// Computes only the output rows [firstRow, lastRow) (output points to the first of them),
+// horizontally scaling just the input rows they need. The contributions are the ones of
+// calculateContributions() for (inputWidth, outputWidth) and (inputHeight, output height).
+// Runs on the calling thread, so several bands of one image can be scaled by independent tasks.
+template<typename T>
+void Resampler::resampleRows(const T *input, int inputWidth, int inputHeight, int channels,
+                             T *output, int outputWidth, int firstRow, int lastRow,
+                             const Contributions &horizontal, const Contributions &vertical) const {
+    const int inputRowSize = inputWidth * channels;
+    const int outputRowSize = outputWidth * channels;
+
+    //where the horizontally scaled version of an input row is stored (-1: not needed)
+    std::vector<int> slots(inputHeight, -1);
+    int slotCount = 0;
+    for(size_t i = (size_t)firstRow * vertical.taps; i < (size_t)lastRow * vertical.taps; i++) {
+        if(vertical.weights[i] != 0.0f && slots[vertical.indices[i]] < 0)
+            slots[vertical.indices[i]] = slotCount++;
+    }
+
+    std::vector< T, PoolAllocator<T> > temp((size_t)outputRowSize * slotCount);
+
+    for(int y = 0; y < inputHeight; y++) {
+        if(slots[y] >= 0)
+            scaleRow(&input[(size_t)y * inputRowSize], horizontal, channels, outputWidth, &temp[(size_t)slots[y] * outputRowSize]);
+    }
+
+    for(int y = firstRow; y < lastRow; y++) {
+        const int *indices = &vertical.indices[(size_t)y * vertical.taps];
+        const float *weights = &vertical.weights[(size_t)y * vertical.taps];
+        T *outputRow = &output[(size_t)(y - firstRow) * outputRowSize];
+
+        for(int i = 0; i < outputRowSize; i++) {
+            outputRow[i] = 0;
+        }
+
+        for(int t = 0; t < vertical.taps; t++) {
+            if(weights[t] == 0.0f)
+                continue;
+
+            const T *tempRow = &temp[(size_t)slots[indices[t]] * outputRowSize];
+            const T w = weights[t];
+
+            for(int i = 0; i < outputRowSize; i++) {
+                outputRow[i] += w * tempRow[i];
+            }
+        }
+    }
+}
+
+template<typename T>
+void Resampler::scaleRow(const T *inputRow, const Contributions &horizontal, int channels, int outputWidth, T *outputRow) const {
+    for(int x = 0; x < outputWidth; x++) {
+        const int *indices = &horizontal.indices[(size_t)x * horizontal.taps];
+        const float *weights = &horizontal.weights[(size_t)x * horizontal.taps];
+
+        for(int c = 0; c < channels; c++) {
+            T sum = 0;
+
+            for(int t = 0; t < horizontal.taps; t++) {
+                sum += weights[t] * inputRow[indices[t] * channels + c];
+            }
+
+            outputRow[x * channels + c] = sum;
+        }
+    }
+}
+
+template void Resampler::resample<float>(const float*, int, int, int, float*, int, int) const;
+template void Resampler::resample<double>(const double*, int, int, int, double*, int, int) const;
+template void Resampler::resampleRows<float>(const float*, int, int, int, float*, int, int, int,
+                                             const Contributions&, const Contributions&) const;
+template void Resampler::resampleRows<double>(const double*, int, int, int, double*, int, int, int,
+                                              const Contributions&, const Contributions&) const;
+
+// Every output pixel gets the same number of taps (unused ones have weight 0),
+// so the inner loops of resample() have a fixed length.
+Resampler::Contributions Resampler::calculateContributions(int inputSize, int outputSize) const {
+    const double scale = (double)outputSize / inputSize;
+    //when scaling down the filter is stretched so it covers all input pixels
+    const double filterScale = std::max(1.0 / scale, 1.0);
+    const double filterSupport = support() * filterScale;
+
+    Contributions result;
+    result.taps = (int)ceil(2.0 * filterSupport) + 1;
+    result.indices = std::vector<int>((size_t)outputSize * result.taps, 0);
+    result.weights = std::vector<float>((size_t)outputSize * result.taps, 0.0f);
+
+    for(int i = 0; i < outputSize; i++) {
+        //center of the output pixel in input coordinates
+        const double center = (i + 0.5) / scale;
+        const int first = (int)floor(center - filterSupport);
+        int *indices = &result.indices[(size_t)i * result.taps];
+        float *weights = &result.weights[(size_t)i * result.taps];
+
+        double sum = 0.0;
+        for(int t = 0; t < result.taps; t++) {
+            const int position = first + t;
+            const double w = weight((position + 0.5 - center) / filterScale);
+
+            indices[t] = handleEdges(position, inputSize);
+            weights[t] = w;
+            sum += w;
+        }
+
+        if(sum != 0.0) {
+            for(int t = 0; t < result.taps; t++) {
+                weights[t] /= sum;
+            }
+        }
+        else {
+            //filter too narrow to hit a pixel center, take the nearest pixel
+            const int nearest = std::min(std::max((int)floor(center) - first, 0), result.taps - 1);
+            indices[nearest] = handleEdges((int)floor(center), inputSize);
+            weights[nearest] = 1.0f;
+        }
+    }
+
+    return result;
+}
+
+//radius of the filter kernel (in pixels when not scaling down)
+double Resampler::support() const {
+    switch(filter) {
+    case BOX:
+        return 0.5;
+    case BILINEAR:
+        return 1.0;
+    case LANCZOS3:
+        return 3.0;
+    case MITCHELL:
+        return 2.0;
+    }
+
+    return 1.0;
+}
+
+double Resampler::weight(double x) const {
+    x = fabs(x);
+
+    switch(filter) {
+    case BOX:
+        return x < 0.5 ? 1.0 : 0.0;
+    case BILINEAR:
+        return x < 1.0 ? 1.0 - x : 0.0;
+    case LANCZOS3:
+    {
+        if(x < 1.0e-8)
+            return 1.0;
+        if(x >= 3.0)
+            return 0.0;
+
+        const double piX = M_PI * x;
+        return 3.0 * sin(piX) * sin(piX / 3.0) / (piX * piX);
+    }
+    case MITCHELL:
+    {
+        //Mitchell-Netravali with B = C = 1/3
+        const double B = 1.0 / 3.0;
+        const double C = 1.0 / 3.0;
+
+        if(x < 1.0) {
+            return ((12.0 - 9.0 * B - 6.0 * C) * x * x * x
+                    + (-18.0 + 12.0 * B + 6.0 * C) * x * x
+                    + (6.0 - 2.0 * B)) / 6.0;
+        }
+        if(x < 2.0) {
+            return ((-B - 6.0 * C) * x * x * x
+                    + (6.0 * B + 30.0 * C) * x * x
+                    + (-12.0 * B - 48.0 * C) * x
+                    + (8.0 * B + 24.0 * C)) / 6.0;
+        }
+        return 0.0;
+    }
+    }
+
+    return 0.0;
+}
+
+int Resampler::handleEdges(int iterator, int max) const {
+    if(tileable) {
+        //wrap around, also if the filter is larger than the image
+        const int wrapped = iterator % max;
+        return wrapped < 0 ? wrapped + max : wrapped;
+    }
+
+    return std::min(std::max(iterator, 0), max - 1);
+}
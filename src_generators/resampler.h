@@ -0,0 +1,78 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <QImage>
+#include "intensitymap.h"
+#include "normalfield.h"
+
+// Separable, multithreaded image scaling with a choice of filters.
+// Works on 8 and 16 bit QImages (filtered with premultiplied alpha), float normal fields
+// and intensity maps. For tileable textures the filter wraps around at the borders,
+// otherwise the edge pixels are repeated.
+class Resampler
+{
+public:
+    enum Filter {
+        BOX,
+        BILINEAR,
+        LANCZOS3,
+        MITCHELL
+    };
+
+    Resampler(Filter filter = MITCHELL, bool tileable = false);
+    QImage scaled(const QImage &image, int width, int height) const;
+    IntensityMap scaled(const IntensityMap &map, int width, int height) const;
+    NormalField scaled(const NormalField &field, int width, int height) const;
+    //formats that lose precision when they are converted to ARGB32
+    static bool moreThan8BitsPerChannel(const QImage &image);
+
+    // for every output pixel of one axis: the input pixels and their weights
+    struct Contributions {
+        int taps;
+        std::vector<int> indices;
+        std::vector<float> weights;
+    };
+
+    template<typename T>
+    void resample(const T *input, int inputWidth, int inputHeight, int channels,
+                  T *output, int outputWidth, int outputHeight) const;
+    //the contributions of both axes are calculated once for all bands of an image
+    Contributions calculateContributions(int inputSize, int outputSize) const;
+    template<typename T>
+    void resampleRows(const T *input, int inputWidth, int inputHeight, int channels,
+                      T *output, int outputWidth, int firstRow, int lastRow,
+                      const Contributions &horizontal, const Contributions &vertical) const;
+
+private:
+    Filter filter;
+    bool tileable;
+
+    template<typename T>
+    void scaleRow(const T *inputRow, const Contributions &horizontal, int channels, int outputWidth, T *outputRow) const;
+    double support() const;
+    double weight(double x) const;
+    int handleEdges(int iterator, int max) const;
+};
+
+#endif // RESAMPLER_H
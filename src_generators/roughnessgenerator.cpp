@@ -0,0 +1,161 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#include "roughnessgenerator.h"
+#include <cmath>
+
+//columns per thread in the vertical pass
+static const int ROUGHNESS_COLUMN_BLOCK = 64;
+//mean normals shorter than this are treated as this long (normals spread over the whole hemisphere)
+static const float ROUGHNESS_MIN_LENGTH = 1.0e-3f;
+
+RoughnessGenerator::RoughnessGenerator()
+    : progress(0)
+{
+}
+
+//optional, rows are reported to it and it can cancel the calculation
+void RoughnessGenerator::setProgress(GeneratorProgress *progress) {
+    this->progress = progress;
+}
+
+IntensityMap RoughnessGenerator::calculateRoughness(const NormalField &normals, int footprint, double baseRoughness,
+                                                    bool tileable, bool gloss) {
+    const int width = normals.getWidth();
+    const int height = normals.getHeight();
+    IntensityMap result(width, height);
+    if(width == 0 || height == 0)
+        return result;
+
+    if(progress)
+        progress->addWork(height + (width + ROUGHNESS_COLUMN_BLOCK - 1) / ROUGHNESS_COLUMN_BLOCK);
+
+    //the window has an odd width, for tileable maps it must not overlap itself
+    int radius = std::max(footprint / 2, 0);
+    if(tileable)
+        radius = std::min(radius, (std::min(width, height) - 1) / 2);
+    const float norm = 1.0f / ((2 * radius + 1) * (2 * radius + 1));
+    const float baseSquared = baseRoughness * baseRoughness;
+
+    const float *nx = normals.planeX();
+    const float *ny = normals.planeY();
+    const float *nz = normals.planeZ();
+    //horizontal box sums of the three components
+    Buffer sumX((size_t)width * height);
+    Buffer sumY((size_t)width * height);
+    Buffer sumZ((size_t)width * height);
+    double *resultData = result.data();
+    const int blocks = (width + ROUGHNESS_COLUMN_BLOCK - 1) / ROUGHNESS_COLUMN_BLOCK;
+
+    //box means as running sums, the cost does not depend on the footprint.
+    //Both directions in one parallel region, the threads meet between them
+    #pragma omp parallel  // OpenMP
+    {
+        #pragma omp for
+        for(int y = 0; y < height; y++) {
+            if(progress && progress->isCanceled())
+                continue;
+
+            const size_t row = (size_t)y * width;
+            //double sums, the running sums would drift in float
+            double x0 = 0.0, y0 = 0.0, z0 = 0.0;
+
+            for(int i = -radius; i <= radius; i++) {
+                const size_t pos = row + handleEdges(i, width, tileable);
+                x0 += nx[pos];
+                y0 += ny[pos];
+                z0 += nz[pos];
+            }
+
+            for(int x = 0; x < width; x++) {
+                sumX[row + x] = x0;
+                sumY[row + x] = y0;
+                sumZ[row + x] = z0;
+
+                const size_t added = row + handleEdges(x + radius + 1, width, tileable);
+                const size_t removed = row + handleEdges(x - radius, width, tileable);
+                x0 += nx[added] - nx[removed];
+                y0 += ny[added] - ny[removed];
+                z0 += nz[added] - nz[removed];
+            }
+
+            if(progress)
+                progress->advance();
+        }
+
+        #pragma omp for
+        for(int block = 0; block < blocks; block++) {
+            if(progress && progress->isCanceled())
+                continue;
+
+            const int firstColumn = block * ROUGHNESS_COLUMN_BLOCK;
+            const int columns = std::min(ROUGHNESS_COLUMN_BLOCK, width - firstColumn);
+            double columnX[ROUGHNESS_COLUMN_BLOCK] = {0.0};
+            double columnY[ROUGHNESS_COLUMN_BLOCK] = {0.0};
+            double columnZ[ROUGHNESS_COLUMN_BLOCK] = {0.0};
+
+            for(int i = -radius; i <= radius; i++) {
+                const size_t row = (size_t)handleEdges(i, height, tileable) * width + firstColumn;
+                for(int c = 0; c < columns; c++) {
+                    columnX[c] += sumX[row + c];
+                    columnY[c] += sumY[row + c];
+                    columnZ[c] += sumZ[row + c];
+                }
+            }
+
+            for(int y = 0; y < height; y++) {
+                const size_t row = (size_t)y * width + firstColumn;
+                const size_t added = (size_t)handleEdges(y + radius + 1, height, tileable) * width + firstColumn;
+                const size_t removed = (size_t)handleEdges(y - radius, height, tileable) * width + firstColumn;
+
+                #pragma omp simd
+                for(int c = 0; c < columns; c++) {
+                    //length of the mean normal, the variance of the normals is (1 - length) / length
+                    const float meanX = columnX[c] * norm;
+                    const float meanY = columnY[c] * norm;
+                    const float meanZ = columnZ[c] * norm;
+                    const float length = std::max(std::sqrt(meanX * meanX + meanY * meanY + meanZ * meanZ), ROUGHNESS_MIN_LENGTH);
+                    const float variance = (1.0f - std::min(length, 1.0f)) / length;
+                    const float roughness = std::sqrt(std::min(baseSquared + variance, 1.0f));
+
+                    resultData[row + c] = gloss ? 1.0f - roughness : roughness;
+
+                    columnX[c] += sumX[added + c] - sumX[removed + c];
+                    columnY[c] += sumY[added + c] - sumY[removed + c];
+                    columnZ[c] += sumZ[added + c] - sumZ[removed + c];
+                }
+            }
+
+            if(progress)
+                progress->advance();
+        }
+    }
+
+    return result;
+}
+
+//wraps around for tileable maps, repeats the edge otherwise
+int RoughnessGenerator::handleEdges(int iterator, int max, bool tileable) const {
+    if(tileable)
+        return ((iterator % max) + max) % max;
+
+    return std::min(std::max(iterator, 0), max - 1);
+}
@@ -0,0 +1,50 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#ifndef ROUGHNESSGENERATOR_H
+#define ROUGHNESSGENERATOR_H
+
+#include "intensitymap.h"
+#include "normalfield.h"
+#include "generatorprogress.h"
+
+// Roughness from the variance of the normals (Toksvig): averaging the normals of a footprint
+// (e.g. what a lower mip level or a distant texel covers) shortens the mean normal, the shorter
+// it is the wider the normals are spread. This spread is added to a base roughness,
+// so shading of mipmapped normalmaps does not get too shiny and aliased.
+class RoughnessGenerator
+{
+public:
+    RoughnessGenerator();
+    //footprint: width of the averaged area in pixels, gloss: output 1 - roughness
+    IntensityMap calculateRoughness(const NormalField &normals, int footprint, double baseRoughness,
+                                    bool tileable, bool gloss = false);
+    void setProgress(GeneratorProgress *progress);
+
+private:
+    typedef std::vector< float, PoolAllocator<float> > Buffer;
+
+    GeneratorProgress *progress;
+
+    int handleEdges(int iterator, int max, bool tileable) const;
+};
+
+#endif // ROUGHNESSGENERATOR_H
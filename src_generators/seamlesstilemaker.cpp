@@ -0,0 +1,290 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#include "seamlesstilemaker.h"
+#include "resampler.h"
+#include <QSize>
+#include <cmath>
+
+//the smallest level of the pyramid, it holds the lowest frequencies that are blended
+static const int SEAMLESS_MIN_LEVEL_SIZE = 8;
+
+SeamlessTileMaker::SeamlessTileMaker()
+    : progress(0)
+{
+}
+
+//optional, the pyramid levels are reported to it and it can cancel the calculation
+void SeamlessTileMaker::setProgress(GeneratorProgress *progress) {
+    this->progress = progress;
+}
+
+QImage SeamlessTileMaker::makeSeamless(const QImage &image) const {
+    if(image.isNull())
+        return QImage();
+
+    const int width = image.width();
+    const int height = image.height();
+    Buffer channels((size_t)width * height * 4);
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+    //keep 16 bit per channel images in 16 bit
+    if(image.depth() == 64) {
+        const QImage rgba = image.convertToFormat(QImage::Format_RGBA64);
+
+        #pragma omp parallel for  // OpenMP
+        for(int y = 0; y < height; y++) {
+            const quint16 *scanline = (const quint16*) rgba.constScanLine(y);
+            float *row = &channels[(size_t)y * width * 4];
+
+            for(int i = 0; i < width * 4; i++) {
+                row[i] = scanline[i];
+            }
+        }
+
+        makeSeamless(channels, width, height, 4);
+
+        QImage result(width, height, QImage::Format_RGBA64);
+
+        #pragma omp parallel for  // OpenMP
+        for(int y = 0; y < height; y++) {
+            quint16 *scanline = (quint16*) result.scanLine(y);
+            const float *row = &channels[(size_t)y * width * 4];
+
+            for(int i = 0; i < width * 4; i++) {
+                scanline[i] = (quint16)std::min(std::max(row[i] + 0.5f, 0.0f), 65535.0f);
+            }
+        }
+
+        return result;
+    }
+#endif
+
+    //8 bit per channel, every channel is blended on its own so the byte order does not matter
+    const QImage argb = image.convertToFormat(QImage::Format_ARGB32);
+
+    #pragma omp parallel for  // OpenMP
+    for(int y = 0; y < height; y++) {
+        const uchar *scanline = argb.constScanLine(y);
+        float *row = &channels[(size_t)y * width * 4];
+
+        for(int i = 0; i < width * 4; i++) {
+            row[i] = scanline[i];
+        }
+    }
+
+    makeSeamless(channels, width, height, 4);
+
+    QImage result(width, height, QImage::Format_ARGB32);
+
+    #pragma omp parallel for  // OpenMP
+    for(int y = 0; y < height; y++) {
+        uchar *scanline = result.scanLine(y);
+        const float *row = &channels[(size_t)y * width * 4];
+
+        for(int i = 0; i < width * 4; i++) {
+            scanline[i] = (uchar)(std::min(std::max(row[i], 0.0f), 255.0f) + 0.5f);
+        }
+    }
+
+    return result;
+}
+
+IntensityMap SeamlessTileMaker::makeSeamless(const IntensityMap &map) const {
+    const int width = map.getWidth();
+    const int height = map.getHeight();
+    if(width == 0 || height == 0)
+        return IntensityMap();
+
+    Buffer channel(map.data(), map.data() + (size_t)width * height);
+    makeSeamless(channel, width, height, 1);
+
+    IntensityMap result(width, height);
+    double *resultData = result.data();
+
+    #pragma omp parallel for  // OpenMP
+    for(int i = 0; i < width * height; i++) {
+        resultData[i] = std::min(std::max((double)channel[i], 0.0), 1.0);
+    }
+
+    return result;
+}
+
+void SeamlessTileMaker::makeSeamless(Buffer &image, int width, int height, int channels) const {
+    if(progress)
+        progress->addWork(2 * countLevels(width, height));
+
+    blendAcrossSeam(image, width, height, channels, false);
+    blendAcrossSeam(image, width, height, channels, true);
+}
+
+//blends the image with a copy offset by half its width (or height if vertical), the result tiles along that axis
+void SeamlessTileMaker::blendAcrossSeam(Buffer &image, int width, int height, int channels, bool vertical) const {
+    if(progress && progress->isCanceled())
+        return;
+
+    const int levelCount = countLevels(width, height);
+    const Resampler resampler(Resampler::BILINEAR);
+
+    //gaussian pyramids of the image and of the offset copy
+    std::vector<Buffer> pyramidA(levelCount);
+    std::vector<Buffer> pyramidB(levelCount);
+    std::vector<QSize> sizes(levelCount);
+    pyramidA[0] = image;
+    pyramidB[0] = Buffer(image.size());
+    sizes[0] = QSize(width, height);
+
+    const int offsetX = vertical ? 0 : width / 2;
+    const int offsetY = vertical ? height / 2 : 0;
+    Buffer &offsetImage = pyramidB[0];
+
+    #pragma omp parallel for  // OpenMP
+    for(int y = 0; y < height; y++) {
+        const float *sourceRow = &image[(size_t)((y + offsetY) % height) * width * channels];
+        float *row = &offsetImage[(size_t)y * width * channels];
+
+        for(int x = 0; x < width; x++) {
+            const float *source = sourceRow + (size_t)((x + offsetX) % width) * channels;
+            for(int c = 0; c < channels; c++) {
+                row[x * channels + c] = source[c];
+            }
+        }
+    }
+
+    for(int level = 1; level < levelCount; level++) {
+        const QSize &previous = sizes[level - 1];
+        sizes[level] = QSize((previous.width() + 1) / 2, (previous.height() + 1) / 2);
+        const size_t size = (size_t)sizes[level].width() * sizes[level].height() * channels;
+
+        pyramidA[level] = Buffer(size);
+        pyramidB[level] = Buffer(size);
+        resampler.resample(&pyramidA[level - 1][0], previous.width(), previous.height(), channels,
+                           &pyramidA[level][0], sizes[level].width(), sizes[level].height());
+        resampler.resample(&pyramidB[level - 1][0], previous.width(), previous.height(), channels,
+                           &pyramidB[level][0], sizes[level].width(), sizes[level].height());
+    }
+
+    //the transition between the two images gets wider with every level, but never reaches
+    //the borders of the image (seam of the original) or its middle (seam of the offset copy)
+    const float fullSize = vertical ? height : width;
+    const int top = levelCount - 1;
+    Buffer result;
+    blendLevel(pyramidA[top], pyramidB[top], sizes[top].width(), sizes[top].height(), channels,
+               vertical, std::min((float)(1 << top) / fullSize, 0.25f), result);
+
+    if(progress)
+        progress->advance();
+
+    //collapse the pyramid: expanded blend of the coarser levels + blended laplacian of this level
+    for(int level = top - 1; level >= 0; level--) {
+        if(progress && progress->isCanceled())
+            return;
+
+        const QSize &size = sizes[level];
+        const QSize &coarse = sizes[level + 1];
+        const size_t count = (size_t)size.width() * size.height() * channels;
+
+        Buffer expandedResult(count);
+        Buffer expandedA(count);
+        Buffer expandedB(count);
+        resampler.resample(&result[0], coarse.width(), coarse.height(), channels,
+                           &expandedResult[0], size.width(), size.height());
+        resampler.resample(&pyramidA[level + 1][0], coarse.width(), coarse.height(), channels,
+                           &expandedA[0], size.width(), size.height());
+        resampler.resample(&pyramidB[level + 1][0], coarse.width(), coarse.height(), channels,
+                           &expandedB[0], size.width(), size.height());
+
+        //laplacian levels (stored in the expanded buffers, the gaussian level is expanded in the next step),
+        //the coarser levels are no longer needed
+        Buffer &laplacianA = expandedA;
+        Buffer &laplacianB = expandedB;
+        pyramidA[level + 1] = Buffer();
+        pyramidB[level + 1] = Buffer();
+
+        #pragma omp parallel for  // OpenMP
+        for(int y = 0; y < size.height(); y++) {
+            const size_t row = (size_t)y * size.width() * channels;
+            for(size_t i = row; i < row + (size_t)size.width() * channels; i++) {
+                laplacianA[i] = pyramidA[level][i] - expandedA[i];
+                laplacianB[i] = pyramidB[level][i] - expandedB[i];
+            }
+        }
+
+        blendLevel(laplacianA, laplacianB, size.width(), size.height(), channels,
+                   vertical, std::min((float)(1 << level) / fullSize, 0.25f), result);
+
+        #pragma omp parallel for  // OpenMP
+        for(int y = 0; y < size.height(); y++) {
+            const size_t row = (size_t)y * size.width() * channels;
+            for(size_t i = row; i < row + (size_t)size.width() * channels; i++) {
+                result[i] += expandedResult[i];
+            }
+        }
+
+        if(progress)
+            progress->advance();
+    }
+
+    image.swap(result);
+}
+
+//result = a * mask + b * (1 - mask), the mask is 1 in the middle half of the axis and 0 near the borders,
+//transition is the width of the ramp between them as a fraction of the axis
+void SeamlessTileMaker::blendLevel(const Buffer &a, const Buffer &b, int width, int height, int channels,
+                                   bool vertical, float transition, Buffer &result) const {
+    const int axisSize = vertical ? height : width;
+    std::vector<float> mask(axisSize);
+
+    for(int i = 0; i < axisSize; i++) {
+        const float position = (i + 0.5f) / axisSize;
+        const float borderDistance = std::min(position, 1.0f - position);
+        mask[i] = std::min(std::max((borderDistance - 0.25f) / transition + 0.5f, 0.0f), 1.0f);
+    }
+
+    result.resize((size_t)width * height * channels);
+
+    #pragma omp parallel for  // OpenMP
+    for(int y = 0; y < height; y++) {
+        const size_t row = (size_t)y * width * channels;
+
+        for(int x = 0; x < width; x++) {
+            const float weight = vertical ? mask[y] : mask[x];
+            const size_t pixel = row + (size_t)x * channels;
+
+            for(int c = 0; c < channels; c++) {
+                result[pixel + c] = b[pixel + c] + (a[pixel + c] - b[pixel + c]) * weight;
+            }
+        }
+    }
+}
+
+//halving the size until the smaller side reaches SEAMLESS_MIN_LEVEL_SIZE
+int SeamlessTileMaker::countLevels(int width, int height) const {
+    int levels = 1;
+    int size = std::min(width, height);
+
+    while(size >= SEAMLESS_MIN_LEVEL_SIZE * 2) {
+        size = (size + 1) / 2;
+        levels++;
+    }
+
+    return levels;
+}
@@ -0,0 +1,55 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#ifndef SEAMLESSTILEMAKER_H
+#define SEAMLESSTILEMAKER_H
+
+#include <QImage>
+#include "intensitymap.h"
+#include "generatorprogress.h"
+
+// Makes a texture that does not tile seamless, so it can be used with the tileable options.
+// The image is blended with a copy of itself that is offset by half its size (the borders of
+// the copy meet in the middle and its middle is at the borders, so it tiles there). The blend
+// is done per frequency band of a laplacian pyramid: fine detail switches sharply between
+// the two images, while the low frequencies are blended across a wide area.
+// Both axes are handled one after another, this way no point has a seam in both images.
+class SeamlessTileMaker
+{
+public:
+    SeamlessTileMaker();
+    QImage makeSeamless(const QImage &image) const;
+    IntensityMap makeSeamless(const IntensityMap &map) const;
+    void setProgress(GeneratorProgress *progress);
+
+private:
+    typedef std::vector< float, PoolAllocator<float> > Buffer;
+
+    GeneratorProgress *progress;
+
+    void makeSeamless(Buffer &image, int width, int height, int channels) const;
+    void blendAcrossSeam(Buffer &image, int width, int height, int channels, bool vertical) const;
+    void blendLevel(const Buffer &a, const Buffer &b, int width, int height, int channels,
+                    bool vertical, float transition, Buffer &result) const;
+    int countLevels(int width, int height) const;
+};
+
+#endif // SEAMLESSTILEMAKER_H
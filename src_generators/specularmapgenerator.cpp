@@ -21,6 +21,7 @@
 
 #include "specularmapgenerator.h"
 #include <QColor>
+#include <algorithm>
 
 SpecularmapGenerator::SpecularmapGenerator(IntensityMap::Mode mode, double redMultiplier, double greenMultiplier, double blueMultiplier, double alphaMultiplier)
 {
@@ -29,6 +30,18 @@ SpecularmapGenerator::SpecularmapGenerator(IntensityMap::Mode mode, double redMu
     this->greenMultiplier = greenMultiplier;
     this->blueMultiplier = blueMultiplier;
     this->alphaMultiplier = alphaMultiplier;
+    this->progress = 0;
+    this->tileMask = 0;
+}
+
+//optional, rows are reported to it and it can cancel the calculation
+void SpecularmapGenerator::setProgress(GeneratorProgress *progress) {
+    this->progress = progress;
+}
+
+//optional, the empty tiles are skipped and stay transparent black
+void SpecularmapGenerator::setTileMask(const TileMask *tileMask) {
+    this->tileMask = (tileMask && !tileMask->isNull()) ? tileMask : 0;
 }
 
 QImage SpecularmapGenerator::calculateSpecmap(const QImage &input, double scale, double contrast) {
@@ -36,36 +49,33 @@ QImage SpecularmapGenerator::calculateSpecmap(const QImage &input, double scale,
     
     //generate contrast lookup table
     unsigned short contrastLookup[256];
-    double newValue = 0;
-    
-    for(int i = 0; i < 256; i++) {
-        newValue = (double)i;
-        newValue /= 255.0;
-        newValue -= 0.5;
-        newValue *= contrast;
-        newValue += 0.5;
-        newValue *= 255;
-    
-        if(newValue < 0)
-            newValue = 0;
-        if(newValue > 255)
-            newValue = 255;
-        
-        contrastLookup[i] = (unsigned short)newValue;
-    }
+    generateContrastLookup(contrast, contrastLookup);
     
     // This is outside of the loop because the multipliers are the same for every pixel
     double multiplierSum = (redMultiplier + greenMultiplier + blueMultiplier + alphaMultiplier);
     if(multiplierSum == 0.0)
         multiplierSum = 1.0;
 
+    if(progress)
+        progress->addWork(result.height());
+
     #pragma omp parallel for  // OpenMP
     //for every row of the image
     for(int y = 0; y < result.height(); y++) {
+        if(progress && progress->isCanceled())
+            continue;
+
         QRgb *scanline = (QRgb*) result.scanLine(y);
 
         //for every column of the image
         for(int x = 0; x < result.width(); x++) {
+            if(tileMask && tileMask->isEmpty(x, y)) {
+                const int end = tileMask->emptyRunEnd(x, y, result.width());
+                std::fill(scanline + x, scanline + end, qRgba(0, 0, 0, 0));
+                x = end - 1;
+                continue;
+            }
+
             double intensity = 0.0;
 
             const QColor pxColor = QColor(input.pixel(x, y));
@@ -102,7 +112,140 @@ QImage SpecularmapGenerator::calculateSpecmap(const QImage &input, double scale,
             //write color into image pixel
             scanline[x] = qRgba(c, c, c, pxColor.alpha());
         }
+
+        if(progress)
+            progress->advance();
     }
 
     return result;
 }
+
+// Integer version of calculateSpecmap() for 8 bit inputs, the channel weights are
+// 16 bit fixed-point values. The intensity matches the floating point version within +-1
+// (before the contrast lookup, which can stretch the difference)
+QImage SpecularmapGenerator::calculateSpecmapFixedPoint(const QImage &input, double scale, double contrast) {
+    QImage result(input.width(), input.height(), QImage::Format_ARGB32);
+    const QImage inputARGB = input.convertToFormat(QImage::Format_ARGB32);
+
+    //generate contrast lookup table
+    unsigned short contrastLookup[256];
+    generateContrastLookup(contrast, contrastLookup);
+
+    double multiplierSum = (redMultiplier + greenMultiplier + blueMultiplier + alphaMultiplier);
+    if(multiplierSum == 0.0 || mode == IntensityMap::MAX)
+        multiplierSum = 1.0;
+
+    //channel weights (including scale), 16 bit fraction. A weight of 256 already clamps every
+    //channel value that is not 0 to 255, so limiting them keeps the weighted sum inside 32 bit
+    const double maxWeight = 256.0;
+    const unsigned int weightRed = (unsigned int)(std::min(redMultiplier / multiplierSum * scale, maxWeight) * 65536.0 + 0.5);
+    const unsigned int weightGreen = (unsigned int)(std::min(greenMultiplier / multiplierSum * scale, maxWeight) * 65536.0 + 0.5);
+    const unsigned int weightBlue = (unsigned int)(std::min(blueMultiplier / multiplierSum * scale, maxWeight) * 65536.0 + 0.5);
+    const unsigned int weightAlpha = (unsigned int)(std::min(alphaMultiplier / multiplierSum * scale, maxWeight) * 65536.0 + 0.5);
+
+    if(progress)
+        progress->addWork(result.height());
+
+    #pragma omp parallel for  // OpenMP
+    //for every row of the image
+    for(int y = 0; y < result.height(); y++) {
+        if(progress && progress->isCanceled())
+            continue;
+
+        const QRgb *scanlineInput = (const QRgb*) inputARGB.constScanLine(y);
+        QRgb *scanline = (QRgb*) result.scanLine(y);
+
+        //for every column of the image
+        for(int x = 0; x < result.width(); x++) {
+            if(tileMask && tileMask->isEmpty(x, y)) {
+                const int end = tileMask->emptyRunEnd(x, y, result.width());
+                std::fill(scanline + x, scanline + end, qRgba(0, 0, 0, 0));
+                x = end - 1;
+                continue;
+            }
+
+            const QRgb pxColor = scanlineInput[x];
+
+            const unsigned int r = qRed(pxColor) * weightRed;
+            const unsigned int g = qGreen(pxColor) * weightGreen;
+            const unsigned int b = qBlue(pxColor) * weightBlue;
+            const unsigned int a = qAlpha(pxColor) * weightAlpha;
+
+            //intensity in the 0-255 range, 16 bit fraction
+            unsigned int intensity = 0;
+
+            if(mode == IntensityMap::AVERAGE) {
+                //weighted average of all channels (the weights are already divided by their sum)
+                intensity = r + g + b + a;
+            }
+            else if(mode == IntensityMap::MAX) {
+                //take the maximum out of all selected channels
+                intensity = std::max(std::max(r, g), std::max(b, a));
+            }
+
+            //clamp and apply contrast
+            const int c = (int)contrastLookup[std::min(intensity >> 16, 255u)];
+
+            //write color into image pixel
+            scanline[x] = qRgba(c, c, c, qAlpha(pxColor));
+        }
+
+        if(progress)
+            progress->advance();
+    }
+
+    return result;
+}
+
+IntensityMap SpecularmapGenerator::calculateSpecmap(const IntensityMap &input, double scale, double contrast) {
+    const int width = input.getWidth();
+    const int height = input.getHeight();
+    IntensityMap result(width, height);
+
+    if(progress)
+        progress->addWork(height);
+
+    #pragma omp parallel for  // OpenMP
+    for(int y = 0; y < height; y++) {
+        if(progress && progress->isCanceled())
+            continue;
+
+        for(int x = 0; x < width; x++) {
+            if(tileMask && tileMask->isEmpty(x, y)) {
+                x = tileMask->emptyRunEnd(x, y, width) - 1;
+                continue;
+            }
+
+            //apply scale (brightness), then contrast like the lookup table of the 8 bit version
+            double intensity = std::min(input.at(x, y) * scale, 1.0);
+            intensity = (intensity - 0.5) * contrast + 0.5;
+
+            result.setValue(x, y, std::min(std::max(intensity, 0.0), 1.0));
+        }
+
+        if(progress)
+            progress->advance();
+    }
+
+    return result;
+}
+
+void SpecularmapGenerator::generateContrastLookup(double contrast, unsigned short contrastLookup[256]) const {
+    double newValue = 0;
+    
+    for(int i = 0; i < 256; i++) {
+        newValue = (double)i;
+        newValue /= 255.0;
+        newValue -= 0.5;
+        newValue *= contrast;
+        newValue += 0.5;
+        newValue *= 255;
+    
+        if(newValue < 0)
+            newValue = 0;
+        if(newValue > 255)
+            newValue = 255;
+        
+        contrastLookup[i] = (unsigned short)newValue;
+    }
+}
@@ -23,16 +23,28 @@
 #define SPECULARMAPGENERATOR_H
 
 #include "intensitymap.h"
+#include "generatorprogress.h"
+#include "tilemask.h"
 
 class SpecularmapGenerator
 {
 public:
     SpecularmapGenerator(IntensityMap::Mode mode, double redMultiplier, double greenMultiplier, double blueMultiplier, double alphaMultiplier);
     QImage calculateSpecmap(const QImage& input, double scale, double contrast);
+    QImage calculateSpecmapFixedPoint(const QImage& input, double scale, double contrast);
+    //brightness and contrast of a height that is already an intensity (e.g. integrated from a normalmap),
+    //kept in floating point. The empty tiles of the mask are 0
+    IntensityMap calculateSpecmap(const IntensityMap& input, double scale, double contrast);
+    void setProgress(GeneratorProgress *progress);
+    void setTileMask(const TileMask *tileMask);
 
 private:
     double redMultiplier, greenMultiplier, blueMultiplier, alphaMultiplier;
     IntensityMap::Mode mode;
+    GeneratorProgress *progress;
+    const TileMask *tileMask;
+
+    void generateContrastLookup(double contrast, unsigned short contrastLookup[256]) const;
 };
 
 #endif // SPECULARMAPGENERATOR_H
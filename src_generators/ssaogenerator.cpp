@@ -22,27 +22,58 @@
 #include "ssaogenerator.h"
 #include <QVector3D>
 #include <QMatrix4x4>
-#include <QColor>
+#include <algorithm>
+#include <cmath>
 
-SsaoGenerator::SsaoGenerator() {
+SsaoGenerator::SsaoGenerator()
+    : progress(0), tileMask(0)
+{
 }
 
-QImage SsaoGenerator::calculateSsaomap(QImage normalmap, QImage depthmap, float radius, unsigned int kernelSamples, unsigned int noiseSize) {
-    QImage result(normalmap.width(), normalmap.height(), QImage::Format_ARGB32);
+//optional, rows are reported to it and it can cancel the calculation
+void SsaoGenerator::setProgress(GeneratorProgress *progress) {
+    this->progress = progress;
+}
+
+//optional, the empty tiles are skipped and stay white (not occluded)
+void SsaoGenerator::setTileMask(const TileMask *tileMask) {
+    this->tileMask = (tileMask && !tileMask->isNull()) ? tileMask : 0;
+}
+
+QImage SsaoGenerator::calculateSsaomap(QImage normalmap, QImage depthmap, float radius, unsigned int kernelSamples, unsigned int noiseSize, bool tileable) {
+    return calculateSsaomap(NormalField(normalmap), IntensityMap(depthmap, IntensityMap::AVERAGE, true, false, false, false),
+                            radius, kernelSamples, noiseSize, tileable);
+}
+
+QImage SsaoGenerator::calculateSsaomap(const NormalField &normals, const IntensityMap &depthmap, float radius, unsigned int kernelSamples, unsigned int noiseSize, bool tileable) {
+    const int width = normals.getWidth();
+    const int height = normals.getHeight();
+    QImage result(width, height, QImage::Format_ARGB32);
     std::vector<QVector3D> kernel = generateKernel(kernelSamples);
     std::vector<QVector3D> noiseTexture = generateNoise(noiseSize);
+    const int depthWidth = depthmap.getWidth();
+    const int depthHeight = depthmap.getHeight();
+
+    if(progress)
+        progress->addWork(height);
 
     #pragma omp parallel for  // OpenMP
-    for(int y = 0; y < normalmap.height(); y++) {
+    for(int y = 0; y < height; y++) {
+        if(progress && progress->isCanceled())
+            continue;
+
         QRgb *scanline = (QRgb*) result.scanLine(y);
 
-        for(int x = 0; x < normalmap.width(); x++) {
-            QVector3D origin(x, y, 1.0);
+        for(int x = 0; x < width; x++) {
+            if(tileMask && tileMask->isEmpty(x, y)) {
+                const int end = tileMask->emptyRunEnd(x, y, width);
+                std::fill(scanline + x, scanline + end, qRgba(255, 255, 255, 255));
+                x = end - 1;
+                continue;
+            }
 
-            float r = QColor(normalmap.pixel(x, y)).redF();
-            float g = QColor(normalmap.pixel(x, y)).greenF();
-            float b = QColor(normalmap.pixel(x, y)).blueF();
-            QVector3D normal(r, g, b);
+            QVector3D origin(x, y, 1.0);
+            QVector3D normal = normals.at(x, y);
 
             //reorient the kernel along the normal
             //get random vector from noise texture
@@ -62,8 +93,18 @@ QImage SsaoGenerator::calculateSsaomap(QImage normalmap, QImage depthmap, float
                 QVector3D sample = transformMatrix * kernel[i];
                 sample = (sample * radius) + origin;
 
-                //get sample depth
-                float sampleDepth = QColor(depthmap.pixel(x, y)).redF();
+                //get sample depth at the sample position
+                int sampleX = (int)std::floor(sample.x());
+                int sampleY = (int)std::floor(sample.y());
+                if(tileable) {
+                    sampleX = ((sampleX % depthWidth) + depthWidth) % depthWidth;
+                    sampleY = ((sampleY % depthHeight) + depthHeight) % depthHeight;
+                }
+                else {
+                    sampleX = std::min(std::max(sampleX, 0), depthWidth - 1);
+                    sampleY = std::min(std::max(sampleY, 0), depthHeight - 1);
+                }
+                float sampleDepth = depthmap.at(sampleX, sampleY);
 
                 //range check and accumulate
                 float rangeCheck = fabs(origin.z() - sampleDepth) < radius ? 1.0 : 0.0;
@@ -78,6 +119,9 @@ QImage SsaoGenerator::calculateSsaomap(QImage normalmap, QImage depthmap, float
             //write result
             scanline[x] = qRgba(c, c, c, 255);
         }
+
+        if(progress)
+            progress->advance();
     }
 
     return result;
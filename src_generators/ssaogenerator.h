@@ -23,6 +23,9 @@
 #define SSAOGENERATOR_H
 
 #include "intensitymap.h"
+#include "normalfield.h"
+#include "generatorprogress.h"
+#include "tilemask.h"
 #include <QImage>
 
 //code is based on http://john-chapman-graphics.blogspot.de/2013/01/ssao-tutorial.html
@@ -30,9 +33,16 @@ class SsaoGenerator
 {
 public:
     SsaoGenerator();
-    QImage calculateSsaomap(QImage normalmap, QImage depthmap, float radius, unsigned int kernelSamples, unsigned int noiseSize);
+    QImage calculateSsaomap(QImage normalmap, QImage depthmap, float radius, unsigned int kernelSamples, unsigned int noiseSize, bool tileable);
+    //the samples outside of the depthmap wrap around if it is tileable, else they are clamped to its border
+    QImage calculateSsaomap(const NormalField &normals, const IntensityMap &depthmap, float radius, unsigned int kernelSamples, unsigned int noiseSize, bool tileable);
+    void setProgress(GeneratorProgress *progress);
+    void setTileMask(const TileMask *tileMask);
 
 private:
+    GeneratorProgress *progress;
+    const TileMask *tileMask;
+
     std::vector<QVector3D> generateKernel(unsigned int size);
     std::vector<QVector3D> generateNoise(unsigned int size);
 
@@ -0,0 +1,97 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#include "tilemask.h"
+#include <algorithm>
+
+TileMask::TileMask()
+    : tilesX(0), tilesY(0)
+{
+}
+
+TileMask::TileMask(const QImage &mask, int width, int height)
+    : tilesX((width + TILE_SIZE - 1) >> TILE_SHIFT), tilesY((height + TILE_SIZE - 1) >> TILE_SHIFT)
+{
+    std::vector<char> visible((size_t)tilesX * tilesY, 0);
+    const QImage argb = mask.convertToFormat(QImage::Format_ARGB32);
+    const int maskWidth = argb.width();
+    const int maskHeight = argb.height();
+
+    //tiles covered by every mask column
+    std::vector<int> firstTile(maskWidth);
+    std::vector<int> lastTile(maskWidth);
+    for(int x = 0; x < maskWidth; x++) {
+        firstTile[x] = (int)((long long)x * width / maskWidth) >> TILE_SHIFT;
+        lastTile[x] = (int)(((long long)(x + 1) * width - 1) / maskWidth) >> TILE_SHIFT;
+    }
+
+    #pragma omp parallel for  // OpenMP
+    for(int tileY = 0; tileY < tilesY; tileY++) {
+        //mask rows that cover a part of this tile row
+        const int firstRow = (int)((long long)(tileY << TILE_SHIFT) * maskHeight / height);
+        const int lastRow = std::min((int)((long long)(((tileY + 1) << TILE_SHIFT) - 1) * maskHeight / height) + 1, maskHeight);
+        char *tileRow = &visible[(size_t)tileY * tilesX];
+
+        for(int y = firstRow; y < lastRow; y++) {
+            const QRgb *line = (const QRgb*)argb.constScanLine(y);
+            for(int x = 0; x < maskWidth; x++) {
+                if(qAlpha(line[x]) != 0) {
+                    for(int tileX = firstTile[x]; tileX <= lastTile[x]; tileX++)
+                        tileRow[tileX] = 1;
+                }
+            }
+        }
+    }
+
+    //grow by one tile, around the borders too (cheaper than asking whether the map is tileable)
+    tiles.assign(visible.size(), 0);
+
+    for(int tileY = 0; tileY < tilesY; tileY++) {
+        for(int tileX = 0; tileX < tilesX; tileX++) {
+            if(!visible[(size_t)tileY * tilesX + tileX])
+                continue;
+
+            for(int dy = -1; dy <= 1; dy++) {
+                const int neighbourY = (tileY + dy + tilesY) % tilesY;
+
+                for(int dx = -1; dx <= 1; dx++)
+                    tiles[(size_t)neighbourY * tilesX + (tileX + dx + tilesX) % tilesX] = 1;
+            }
+        }
+    }
+
+    //nothing to skip
+    if(std::find(tiles.begin(), tiles.end(), 0) == tiles.end())
+        tiles.clear();
+}
+
+int TileMask::emptyRunEnd(int x, int y, int width) const {
+    const char *tileRow = &tiles[(size_t)(y >> TILE_SHIFT) * tilesX];
+    int tileX = x >> TILE_SHIFT;
+    while(tileX < tilesX && !tileRow[tileX])
+        tileX++;
+
+    return std::min(tileX << TILE_SHIFT, width);
+}
+
+bool TileMask::isNull() const {
+    return tiles.empty();
+}
@@ -0,0 +1,59 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#ifndef TILEMASK_H
+#define TILEMASK_H
+
+#include <QImage>
+#include <vector>
+
+// Coarse occupancy map of an alpha mask for skipping the transparent parts of atlases.
+// A tile is occupied if any pixel of it is not fully transparent, the occupied tiles are
+// grown by one tile so kernels and samples near the covered area still see their neighbours.
+// The generators write a neutral value into the empty tiles instead of calculating them.
+// A mask that covers every tile is null, so the generators don't test the tiles for nothing.
+class TileMask
+{
+public:
+    //tiles are TILE_SIZE x TILE_SIZE pixels of the map
+    static const int TILE_SHIFT = 5;
+    static const int TILE_SIZE = 1 << TILE_SHIFT;
+
+    //null mask: nothing is skipped
+    TileMask();
+    //occupancy for a map of width x height pixels, the mask is stretched over it
+    TileMask(const QImage &mask, int width, int height);
+    bool isNull() const;
+
+    bool isEmpty(int x, int y) const {
+        return !tiles[(size_t)(y >> TILE_SHIFT) * tilesX + (x >> TILE_SHIFT)];
+    }
+
+    //end (exclusive) of the empty tiles in row y from the empty pixel x on, at most width
+    int emptyRunEnd(int x, int y, int width) const;
+
+private:
+    int tilesX;
+    int tilesY;
+    std::vector<char> tiles;
+};
+
+#endif // TILEMASK_H
@@ -0,0 +1,174 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#include "udimset.h"
+#include "resampler.h"
+#include <QFileInfo>
+#include <QDir>
+#include <QRegularExpression>
+#include <cstring>
+#include <algorithm>
+
+UdimSet::UdimSet(const QString &tilePath) {
+    //name, separator (. or _), UDIM number, file suffix
+    const QFileInfo file(tilePath);
+    const QRegularExpression udimName("^(.*)([._])(1\\d{3})\\.([^.]+)$");
+    const QRegularExpressionMatch match = udimName.match(file.fileName());
+    if(!match.hasMatch())
+        return;
+
+    const QString name = match.captured(1);
+    separator = match.captured(2);
+    suffix = match.captured(4);
+    prefix = file.absolutePath() + "/" + name;
+
+    const QDir dir = file.absoluteDir();
+    const QStringList tiles = dir.entryList(QStringList() << name + separator + "1???." + suffix, QDir::Files);
+    for(int i = 0; i < tiles.size(); i++) {
+        const QRegularExpressionMatch tileMatch = udimName.match(tiles.at(i));
+        if(!tileMatch.hasMatch())
+            continue;
+
+        const int udim = tileMatch.captured(3).toInt();
+        if(udim >= 1001)
+            paths.insert(udim, dir.absoluteFilePath(tiles.at(i)));
+    }
+}
+
+bool UdimSet::isEmpty() const {
+    return paths.isEmpty();
+}
+
+QList<int> UdimSet::getTiles() const {
+    return paths.keys();
+}
+
+QString UdimSet::getTilePath(int udim) const {
+    return paths.value(udim);
+}
+
+QString UdimSet::getPrefix() const {
+    return prefix;
+}
+
+QString UdimSet::getSuffix() const {
+    return suffix;
+}
+
+QImage UdimSet::loadWithHalo(int udim, int halo) {
+    const int u = (udim - 1001) % 10;
+
+    //tiles around this one (row by row from the top left), 0 if there is none.
+    //v points up, the tile above in the image is the next row of the set
+    int neighbours[9];
+    for(int dy = -1; dy <= 1; dy++) {
+        for(int dx = -1; dx <= 1; dx++) {
+            const int neighbour = udim + dx - 10 * dy;
+            const bool inRow = u + dx >= 0 && u + dx <= 9;
+            neighbours[(dy + 1) * 3 + dx + 1] = (inRow && paths.contains(neighbour)) ? neighbour : 0;
+        }
+    }
+
+    //only the neighbours stay loaded
+    QMap<int, QImage> tiles;
+    for(int i = 0; i < 9; i++) {
+        if(neighbours[i] != 0 && resident.contains(neighbours[i]))
+            tiles.insert(neighbours[i], resident.value(neighbours[i]));
+    }
+    resident.clear();
+
+    //the missing ones are loaded in parallel
+    QImage loaded[9];
+    #pragma omp parallel for  // OpenMP
+    for(int i = 0; i < 9; i++) {
+        if(neighbours[i] != 0 && !tiles.contains(neighbours[i]))
+            loaded[i] = QImage(paths.value(neighbours[i]));
+    }
+    for(int i = 0; i < 9; i++) {
+        if(!loaded[i].isNull())
+            tiles.insert(neighbours[i], loaded[i]);
+    }
+    resident = tiles;
+
+    const QImage center = tiles.value(udim);
+    if(center.isNull())
+        return QImage();
+
+    const QImage::Format format = center.depth() < 8 ? QImage::Format_ARGB32 : center.format();
+    const int width = center.width();
+    const int height = center.height();
+
+    //the sources of the 9 parts of the result, in the format and size of the center tile
+    QImage sources[9];
+    for(int i = 0; i < 9; i++) {
+        QImage tile = neighbours[i] != 0 ? tiles.value(neighbours[i]) : QImage();
+        if(tile.isNull())
+            continue;
+        if(tile.format() != format)
+            tile = tile.convertToFormat(format);
+        if(tile.width() != width || tile.height() != height)
+            tile = Resampler(Resampler::BILINEAR).scaled(tile, width, height).convertToFormat(format);
+        sources[i] = tile;
+    }
+
+    QImage result(width + 2 * halo, height + 2 * halo, format);
+    const int bytesPerPixel = result.depth() / 8;
+
+    #pragma omp parallel for  // OpenMP
+    for(int y = 0; y < result.height(); y++) {
+        const int tileY = y - halo;
+        const int dy = tileY < 0 ? -1 : (tileY >= height ? 1 : 0);
+        uchar *line = result.scanLine(y);
+
+        for(int x = 0; x < result.width(); x++) {
+            const int tileX = x - halo;
+            const int dx = tileX < 0 ? -1 : (tileX >= width ? 1 : 0);
+            const QImage &neighbour = sources[(dy + 1) * 3 + dx + 1];
+
+            //the position in the neighbour, or the nearest border pixel of the center tile
+            const QImage &source = neighbour.isNull() ? center : neighbour;
+            const int sourceX = neighbour.isNull() ? tileX : tileX - dx * width;
+            const int sourceY = neighbour.isNull() ? tileY : tileY - dy * height;
+            const int clampedX = std::min(std::max(sourceX, 0), width - 1);
+            const int clampedY = std::min(std::max(sourceY, 0), height - 1);
+
+            std::memcpy(line + (size_t)x * bytesPerPixel,
+                        source.constScanLine(clampedY) + (size_t)clampedX * bytesPerPixel, bytesPerPixel);
+        }
+    }
+
+    return result;
+}
+
+QImage UdimSet::cropHalo(const QImage &map, int halo, int tileWidth, int tileHeight) {
+    if(map.isNull() || halo == 0)
+        return map;
+
+    //the map can be scaled (normalmap size), the borders are scaled the same way
+    const int fullWidth = tileWidth + 2 * halo;
+    const int fullHeight = tileHeight + 2 * halo;
+    const int left = (int)((long long)halo * map.width() / fullWidth);
+    const int top = (int)((long long)halo * map.height() / fullHeight);
+    const int right = (int)((long long)(halo + tileWidth) * map.width() / fullWidth);
+    const int bottom = (int)((long long)(halo + tileHeight) * map.height() / fullHeight);
+
+    return map.copy(left, top, right - left, bottom - top);
+}
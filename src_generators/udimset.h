@@ -0,0 +1,62 @@
+/********************************************************************************
+ *   Copyright (C) 2015 by Simon Wendsche                                       *
+ *                                                                              *
+ *   This file is part of NormalmapGenerator.                                   *
+ *                                                                              *
+ *   NormalmapGenerator is free software; you can redistribute it and/or modify *
+ *   it under the terms of the GNU General Public License as published by       *
+ *   the Free Software Foundation; either version 3 of the License, or          *
+ *   (at your option) any later version.                                        *
+ *                                                                              *
+ *   NormalmapGenerator is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ *   GNU General Public License for more details.                               *
+ *                                                                              *
+ *   You should have received a copy of the GNU General Public License          *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ *                                                                              *
+ *   Sourcecode: https://github.com/Theverat/NormalmapGenerator                 *
+ ********************************************************************************/
+
+#ifndef UDIMSET_H
+#define UDIMSET_H
+
+#include <QImage>
+#include <QString>
+#include <QList>
+#include <QMap>
+
+// The tiles of a UDIM set (name.1001.png, name.1002.png ...: 1001 + u + 10 * v).
+// A tile is loaded with a halo of the pixels of its neighbours, so kernels, blurs and
+// ambient occlusion continue across the tile borders instead of clamping or wrapping
+// inside the tile. The tiles are loaded when they are needed and only the neighbours
+// of the last tile stay in memory.
+class UdimSet
+{
+public:
+    //path of any tile of the set
+    explicit UdimSet(const QString &tilePath);
+    bool isEmpty() const;
+    //UDIM numbers of the tiles, ascending
+    QList<int> getTiles() const;
+    QString getTilePath(int udim) const;
+    //path of the set without the UDIM number (folder/name)
+    QString getPrefix() const;
+    QString getSuffix() const;
+    //the tile with halo pixels of its neighbours on every side. Where there is no neighbour
+    //the border of the tile is repeated. Neighbours of another size are scaled to the tile's size
+    QImage loadWithHalo(int udim, int halo);
+    //the part of a map calculated from loadWithHalo() that belongs to the tile (the map can be scaled)
+    static QImage cropHalo(const QImage &map, int halo, int tileWidth, int tileHeight);
+
+private:
+    QString prefix;
+    QString separator;
+    QString suffix;
+    QMap<int, QString> paths;
+    //loaded tiles, the neighbours of the last tile
+    QMap<int, QImage> resident;
+};
+
+#endif // UDIMSET_H
@@ -28,6 +28,20 @@
 #include "src_generators/ssaogenerator.h"
 #include "src_generators/intensitymap.h"
 #include "src_generators/gaussianblur.h"
+#include "src_generators/heightmapgenerator.h"
+#include "src_generators/bufferpool.h"
+#include "src_generators/resampler.h"
+#include "src_generators/photometricstereogenerator.h"
+#include "src_generators/detailnormalcombiner.h"
+#include "src_generators/seamlesstilemaker.h"
+#include "src_generators/roughnessgenerator.h"
+#include "src_generators/horizonmapgenerator.h"
+#include "src_generators/conemapgenerator.h"
+#include "src_generators/distancefieldgenerator.h"
+#include "src_generators/tilemask.h"
+#include "src_generators/atlasprocessor.h"
+#include "src_generators/udimset.h"
+#include "src_generators/imagesequence.h"
 
 #include <QMessageBox>
 #include <QFileDialog>
@@ -39,17 +53,27 @@
 #include <QColorDialog>
 #include <QPixmap>
 #include <QShortcut>
+#include <QTimer>
+#include <QFile>
+#include <QTextStream>
+#include <QEventLoop>
+#include <QFutureWatcher>
+#include <QtConcurrent/QtConcurrentRun>
 
 #include <iostream>
 
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
     ui(new Ui::MainWindow),
+    seamlessInputKey(0),
     lastCalctime_normal(0),
     lastCalctime_specular(0),
     lastCalctime_displace(0),
     lastCalctime_ssao(0),
-    stopQueue(false)
+    stopQueue(false),
+    saveHalo(0),
+    writeMapsInBackground(false),
+    generatorRunning(false)
 {
     ui->setupUi(this);
 
@@ -77,6 +101,13 @@ MainWindow::MainWindow(QWidget *parent) :
 
     //hide queue progressbar
     ui->progressBar_Queue->hide();
+
+    //progress of the map that is currently calculated
+    generatorProgressBar = new QProgressBar();
+    generatorProgressBar->setRange(0, 100);
+    generatorProgressBar->setMaximumWidth(150);
+    generatorProgressBar->hide();
+    ui->statusBar->addPermanentWidget(generatorProgressBar);
     
     // SSAO map generator is not ready yet, remove it from the UI
     ui->tabWidget->removeTab(4);
@@ -169,6 +200,10 @@ void MainWindow::loadAllFromDir(QUrl url) {
 
 //load the image specified in the url
 bool MainWindow::load(QUrl url) {
+    //the running generator still uses the current input
+    if(generatorRunning)
+        return false;
+
     if(!url.isValid()) {
         throw "[load] invalid url!";
         return false;
@@ -206,6 +241,13 @@ bool MainWindow::load(QUrl url) {
         setExportPath(url.adjusted(QUrl::RemoveFilename));
     loadedImagePath = url;
 
+    showLoadedInput();
+
+    return true;
+}
+
+//set up the ui for a new input image, all previously generated maps are cleared
+void MainWindow::showLoadedInput() {
     //enable ui buttons
     ui->pushButton_calcNormal->setEnabled(true);
     ui->pushButton_calcSpec->setEnabled(true);
@@ -216,7 +258,8 @@ bool MainWindow::load(QUrl url) {
     
     //extract R/G/B/A channels
     const int h = ui->label_channelRed->height();
-    QImage inputSmall(input.scaled(h, h, Qt::KeepAspectRatio));
+    const QSize thumbnailSize = input.size().scaled(h, h, Qt::KeepAspectRatio);
+    QImage inputSmall(Resampler(Resampler::BOX).scaled(input, std::max(thumbnailSize.width(), 1), std::max(thumbnailSize.height(), 1)));
     IntensityMap red(inputSmall, IntensityMap::MAX, true, false, false, false);
     IntensityMap green(inputSmall, IntensityMap::MAX, false, true, false, false);
     IntensityMap blue(inputSmall, IntensityMap::MAX, false, false, true, false);
@@ -247,10 +290,8 @@ bool MainWindow::load(QUrl url) {
 
     //clear all previously generated images
     channelIntensity = QImage();
-    normalmap = QImage();
-    specmap = QImage();
-    displacementmap = QImage();
-    ssaomap = QImage();
+    photometricNormals = NormalField();
+    clearMaps();
 
     //display single image channels if the option was already chosen
     if(ui->radioButton_displayRGBA->isChecked())
@@ -269,8 +310,6 @@ bool MainWindow::load(QUrl url) {
     
     //enable button to save the maps
     ui->pushButton_save->setEnabled(true);
-
-    return true;
 }
 
 //load images using the file dialog
@@ -284,9 +323,152 @@ void MainWindow::loadUserFilePath() {
     loadMultipleDropped(urls);
 }
 
+//photometric stereo: the normals are measured from several photos of the surface lit from known directions
+void MainWindow::loadPhotometricStereo() {
+    if(generatorRunning)
+        return;
+
+    QString filter = "Image Formats (" + supportedImageformats.join(" ") + ")";
+    QStringList imagePaths = QFileDialog::getOpenFileNames(this,
+                                                           "Open Photos (one per light direction)",
+                                                           QDir::homePath(),
+                                                           filter);
+    if(imagePaths.isEmpty())
+        return;
+
+    QString lightPath = QFileDialog::getOpenFileName(this,
+                                                     "Open Light Directions (one \"x y z\" line per photo, ordered by file name)",
+                                                     QFileInfo(imagePaths.first()).absolutePath(),
+                                                     "Text Files (*.txt);;All Files (*)");
+    if(lightPath.isEmpty())
+        return;
+
+    //x to the right, y down the image, z towards the camera
+    std::vector<QVector3D> lightDirections;
+    QFile lightFile(lightPath);
+    if(lightFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QTextStream stream(&lightFile);
+        while(!stream.atEnd()) {
+            QStringList values = stream.readLine().simplified().split(' ');
+            if(values.size() == 3)
+                lightDirections.push_back(QVector3D(values.at(0).toFloat(), values.at(1).toFloat(), values.at(2).toFloat()));
+        }
+    }
+
+    if(imagePaths.size() < 3 || (size_t)imagePaths.size() != lightDirections.size()) {
+        QMessageBox::information(this, "Photometric Stereo",
+                                 "At least 3 photos and exactly one light direction per photo are needed.\n"
+                                 "Selected photos: " + QString::number(imagePaths.size()) +
+                                 ", light directions: " + QString::number(lightDirections.size()));
+        return;
+    }
+
+    imagePaths.sort();
+
+    ui->statusBar->showMessage("calculating normalmap from " + QString::number(imagePaths.size()) + " photos...");
+
+    PhotometricStereoGenerator photometricStereoGenerator;
+    photometricStereoGenerator.setProgress(&generatorProgress);
+    NormalField resultNormalField;
+    QImage resultAlbedo;
+
+    bool finished = runGenerator([&]() {
+        resultNormalField = photometricStereoGenerator.calculateNormalField(imagePaths, lightDirections);
+        if(!resultNormalField.isNull())
+            resultAlbedo = photometricStereoGenerator.getAlbedo().convertToQImage();
+    });
+
+    if(!finished) {
+        ui->statusBar->showMessage("calculation of the normalmap was canceled", 5000);
+        return;
+    }
+
+    if(resultNormalField.isNull()) {
+        ui->statusBar->clearMessage();
+        QMessageBox::information(this, "Photometric Stereo",
+                                 "The normalmap could not be calculated.\n"
+                                 "All photos must load and have the same size, and the light directions must not lie in one plane.");
+        return;
+    }
+
+    //the albedo becomes the input of the other maps
+    QUrl url = QUrl::fromLocalFile(imagePaths.first());
+    input = resultAlbedo;
+    if(exportPath.isEmpty())
+        setExportPath(url.adjusted(QUrl::RemoveFilename));
+    loadedImagePath = url;
+    showLoadedInput();
+
+    //the measured normals replace the calculated ones until a new image is loaded
+    photometricNormals = resultNormalField;
+    ui->statusBar->showMessage("integrating the height of the normalmap...");
+    calcPhotometricMaps();
+    ui->statusBar->clearMessage();
+    //previews the normalmap
+    ui->tabWidget->setCurrentIndex(1);
+}
+
+//the maps that depend on the normals measured by photometric stereo. The albedo is no height,
+//the height for the parallax and ambient occlusion maps is integrated from the normals
+void MainWindow::calcPhotometricMaps() {
+    bool tileable = ui->checkBox_tileable->isChecked();
+    //smaller inputs are the LOD variants
+    int roughnessFootprint = std::max(qRound(ui->spinBox_roughnessFootprint->value() * lodScale()), 1);
+    double roughnessBase = ui->doubleSpinBox_roughnessBase->value();
+    bool gloss = ui->checkBox_roughnessGloss->isChecked();
+    //the normals and the height are kept, only cleared maps and other sizes are calculated again
+    const bool keepNormals = !normalField.isNull() && !normalmapRawIntensity.isNull() &&
+            (int)normalField.getWidth() == input.width() && (int)normalField.getHeight() == input.height();
+
+    HeightmapGenerator heightmapGenerator;
+    heightmapGenerator.setProgress(&generatorProgress);
+    NormalmapGenerator curvatureGenerator(IntensityMap::AVERAGE, true, true, true, false);
+    curvatureGenerator.setProgress(&generatorProgress);
+    RoughnessGenerator roughnessGenerator;
+    roughnessGenerator.setProgress(&generatorProgress);
+    NormalField resultNormalField = normalField;
+    IntensityMap resultHeight = normalmapRawIntensity;
+    QImage resultCurvature;
+    QImage resultRoughness;
+
+    bool finished = runGenerator([&]() {
+        if(!keepNormals) {
+            resultNormalField = photometricNormals;
+            if((int)resultNormalField.getWidth() != input.width() || (int)resultNormalField.getHeight() != input.height())
+                resultNormalField = Resampler(Resampler::MITCHELL, tileable).scaled(resultNormalField, input.width(), input.height());
+            resultHeight = heightmapGenerator.calculateHeightmap(resultNormalField, tileable);
+        }
+
+        if(!generatorProgress.isCanceled())
+            resultCurvature = curvatureGenerator.calculateCurvature(resultNormalField).convertToQImage();
+        if(!generatorProgress.isCanceled())
+            resultRoughness = roughnessGenerator.calculateRoughness(resultNormalField, roughnessFootprint, roughnessBase, tileable, gloss).convertToQImage();
+    });
+
+    if(!finished)
+        return;
+
+    normalField = resultNormalField;
+    normalmapRawIntensity = resultHeight;
+    curvaturemap = resultCurvature;
+    roughnessmap = resultRoughness;
+    if(!keepNormals) {
+        normalmap = resultNormalField.convertToQImage();
+        horizonmap0 = QImage();
+        horizonmap1 = QImage();
+        conemap = QImage();
+    }
+}
+
 void MainWindow::calcNormal() {
-    if(input.isNull())
+    if(input.isNull() || generatorRunning)
+        return;
+
+    //measured normals are not calculated from the input
+    if(!photometricNormals.isNull()) {
+        calcPhotometricMaps();
         return;
+    }
 
     //normalmap parameters
     double strength = ui->doubleSpinBox_strength->value();
@@ -318,24 +500,273 @@ void MainWindow::calcNormal() {
     int largeDetailScale = ui->spinBox_largeDetailScale->value();
     double largeDetailHeight = ui->doubleSpinBox_largeDetailHeight->value();
 
-    //scale input image if not 100%
-    QImage inputScaled = input;
-    int sizePercent = ui->spinBox_normalmapSize->value();
-    if(sizePercent != 100) {
-        int scaledWidth = calcPercentage(input.width(), sizePercent);
-        int scaledHeight = calcPercentage(input.height(), sizePercent);
+    //lighting removal (high pass), only in the floating point pipeline
+    bool highPass = ui->checkBox_highPass->isChecked();
+    double highPassRadius = ui->spinBox_highPassRadius->value();
 
-        inputScaled = input.scaled(scaledWidth, scaledHeight, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    //edge preserving denoising, only in the floating point pipeline
+    bool denoise = ui->checkBox_denoise->isChecked();
+    int denoiseRadius = ui->spinBox_denoiseRadius->value();
+    double denoiseEdge = ui->doubleSpinBox_denoiseEdge->value();
+
+    int sizePercent = ui->spinBox_normalmapSize->value();
+    //radii in pixels of the input, for the scaled normalmap and LOD variants
+    const int radiusPercent = std::max(qRound(sizePercent * lodScale()), 1);
+    //the height differences between pixels grow on smaller LOD inputs
+    strength *= lodScale();
+    const bool fixedPoint = useFixedPoint() && !highPass && !denoise;
+    const bool seamless = ui->checkBox_makeSeamless->isChecked();
+    const bool skipTransparent = ui->checkBox_skipTransparent->isChecked();
+    const QList<QRect> cells = atlasCells();
+
+    //existing normalmap the generated normals are put on top of
+    QString baseNormalmapPath;
+    if(ui->checkBox_combineBaseNormalmap->isChecked()) {
+        baseNormalmapPath = findBaseNormalmap();
+        if(baseNormalmapPath.isEmpty()) {
+            ui->statusBar->showMessage("no base normalmap found for " + loadedImagePath.fileName(), 5000);
+            std::cout << "[Normalmap] No base normalmap found for "
+                      << loadedImagePath.toLocalFile().toStdString() << std::endl;
+        }
     }
-    
-    //setup generator and calculate map
+
+    //setup generator
     NormalmapGenerator normalmapGenerator(mode, useRed, useGreen, useBlue, useAlpha);
-    normalmap = normalmapGenerator.calculateNormalmap(inputScaled, kernel, strength, invert, tileable, keepLargeDetail, largeDetailScale, largeDetailHeight);
-    normalmapRawIntensity = normalmapGenerator.getIntensityMap().convertToQImage();
+    normalmapGenerator.setProgress(&generatorProgress);
+    if(highPass)
+        normalmapGenerator.setHighPassRadius(highPassRadius * radiusPercent / 100.0);
+    if(denoise)
+        normalmapGenerator.setDenoise(calcPercentage(denoiseRadius, radiusPercent), denoiseEdge * denoiseEdge);
+    //the curvature is calculated in the same run from the final normals
+    const bool curvature = ui->checkBox_queue_generateCurvature->isChecked();
+    normalmapGenerator.setCurvatureEnabled(curvature && baseNormalmapPath.isEmpty());
+    //roughness from the variance of the final normals
+    const bool roughness = ui->checkBox_queue_generateRoughness->isChecked();
+    int roughnessFootprint = calcPercentage(ui->spinBox_roughnessFootprint->value(), radiusPercent);
+    double roughnessBase = ui->doubleSpinBox_roughnessBase->value();
+    bool gloss = ui->checkBox_roughnessGloss->isChecked();
+    RoughnessGenerator roughnessGenerator;
+    roughnessGenerator.setProgress(&generatorProgress);
+    QImage resultNormalmap;
+    NormalField resultNormalField;
+    IntensityMap resultRawIntensity;
+    QImage resultCurvature;
+    QImage resultRoughness;
+
+    //calculate map
+    bool finished = runGenerator([&]() {
+        //scale input image if not 100%
+        QImage inputScaled = generatorInput(seamless);
+        if(sizePercent != 100 && !generatorProgress.isCanceled()) {
+            int scaledWidth = calcPercentage(input.width(), sizePercent);
+            int scaledHeight = calcPercentage(input.height(), sizePercent);
+
+            inputScaled = Resampler(Resampler::MITCHELL, tileable).scaled(inputScaled, scaledWidth, scaledHeight);
+        }
+
+        if(!cells.isEmpty()) {
+            //every cell with its own generator, the borders of the cells are handled like the image borders
+            const AtlasProcessor atlas = AtlasProcessor(cells).scaled(input.width(), input.height(),
+                                                                      inputScaled.width(), inputScaled.height());
+            std::vector<IntensityMap> intensities(atlas.getCells().size());
+            //the float normals of the cells, the 8 bit maps would quantize the normals of the other generators
+            std::vector<NormalField> cellNormals(fixedPoint ? 0 : atlas.getCells().size());
+
+            resultNormalmap = atlas.process(inputScaled, [&](const QImage &cell, int index) -> QImage {
+                NormalmapGenerator cellGenerator(normalmapGenerator);
+                cellGenerator.setCurvatureEnabled(false);
+                const TileMask cellMask = (skipTransparent && cell.hasAlphaChannel())
+                        ? TileMask(cell, cell.width(), cell.height()) : TileMask();
+                cellGenerator.setTileMask(&cellMask);
+
+                QImage cellNormalmap;
+                if(fixedPoint)
+                    cellNormalmap = cellGenerator.calculateNormalmapFixedPoint(cell, kernel, strength, invert, tileable, keepLargeDetail, largeDetailScale, largeDetailHeight);
+                else {
+                    cellNormals[index] = cellGenerator.calculateNormalField(cell, kernel, strength, invert, tileable, keepLargeDetail, largeDetailScale, largeDetailHeight);
+                    cellNormalmap = cellNormals[index].convertToQImage();
+                }
+                intensities[index] = cellGenerator.getIntensityMap();
+                return cellNormalmap;
+            }, qRgb(128, 128, 255));
+
+            if(fixedPoint)
+                resultNormalField = NormalField(resultNormalmap);
+            else
+                resultNormalField = atlas.assemble(inputScaled.width(), inputScaled.height(), cellNormals);
+            resultRawIntensity = atlas.assemble(inputScaled.width(), inputScaled.height(), intensities);
+        }
+        else {
+            const TileMask tileMask = (skipTransparent && inputScaled.hasAlphaChannel())
+                    ? TileMask(inputScaled, inputScaled.width(), inputScaled.height()) : TileMask();
+            normalmapGenerator.setTileMask(&tileMask);
+
+            if(fixedPoint) {
+                resultNormalmap = normalmapGenerator.calculateNormalmapFixedPoint(inputScaled, kernel, strength, invert, tileable, keepLargeDetail, largeDetailScale, largeDetailHeight);
+                resultNormalField = NormalField(resultNormalmap);
+            }
+            else {
+                //the float normals are kept for the other generators, only the exported map is quantized
+                resultNormalField = normalmapGenerator.calculateNormalField(inputScaled, kernel, strength, invert, tileable, keepLargeDetail, largeDetailScale, largeDetailHeight);
+                resultNormalmap = resultNormalField.convertToQImage();
+            }
+            resultRawIntensity = normalmapGenerator.getIntensityMap();
+            normalmapGenerator.setTileMask(0);
+        }
+
+        if(!baseNormalmapPath.isEmpty()) {
+            QImage baseNormalmap(baseNormalmapPath);
+            if(!baseNormalmap.isNull()) {
+                DetailNormalCombiner combiner(tileable);
+                combiner.setProgress(&generatorProgress);
+                resultNormalField = combiner.combine(NormalField(baseNormalmap), resultNormalField);
+                resultNormalmap = resultNormalField.convertToQImage();
+            }
+        }
+
+        if(curvature && !generatorProgress.isCanceled()) {
+            if(fixedPoint || !baseNormalmapPath.isEmpty() || !cells.isEmpty())
+                resultCurvature = normalmapGenerator.calculateCurvature(resultNormalField).convertToQImage();
+            else
+                resultCurvature = normalmapGenerator.getCurvatureMap().convertToQImage();
+        }
+
+        if(roughness && !generatorProgress.isCanceled())
+            resultRoughness = roughnessGenerator.calculateRoughness(resultNormalField, roughnessFootprint, roughnessBase, tileable, gloss).convertToQImage();
+    });
+
+    if(!finished)
+        return;
+
+    normalmap = resultNormalmap;
+    normalField = resultNormalField;
+    normalmapRawIntensity = resultRawIntensity;
+    curvaturemap = resultCurvature;
+    roughnessmap = resultRoughness;
+    horizonmap0 = QImage();
+    horizonmap1 = QImage();
+    conemap = QImage();
+}
+
+//the base normalmap for the loaded image: either the file entered in the normal tab,
+//or if a folder was entered the file in it that has the same name as the image (optionally followed by "_normal")
+QString MainWindow::findBaseNormalmap() {
+    QFileInfo baseInfo(ui->lineEdit_baseNormalmap->text());
+    if(baseInfo.isFile())
+        return baseInfo.absoluteFilePath();
+    if(!baseInfo.isDir())
+        return QString();
+
+    QFileInfo imageInfo(loadedImagePath.toLocalFile());
+    QString imageName = imageInfo.completeBaseName();
+    QDir baseDir(baseInfo.absoluteFilePath());
+    QStringList candidates = baseDir.entryList(supportedImageformats, QDir::Files, QDir::Name);
+
+    foreach(QString candidate, candidates) {
+        QString candidatePath = baseDir.absoluteFilePath(candidate);
+        QString candidateName = QFileInfo(candidatePath).completeBaseName();
+
+        //the input itself is not its own base
+        if(candidatePath == imageInfo.absoluteFilePath())
+            continue;
+
+        if(candidateName.compare(imageName, Qt::CaseInsensitive) == 0 ||
+           candidateName.compare(imageName + "_normal", Qt::CaseInsensitive) == 0)
+            return candidatePath;
+    }
+
+    return QString();
+}
+
+//cells of the atlas mode in pixels of the input: the rectangles of the list file
+//(one "x y width height" line per cell) or else the grid, empty if the mode is off
+QList<QRect> MainWindow::atlasCells() {
+    QList<QRect> cells;
+    if(!ui->checkBox_atlas->isChecked() || input.isNull())
+        return cells;
+
+    QString rectanglesPath = ui->lineEdit_atlasRectangles->text();
+    if(!rectanglesPath.isEmpty()) {
+        QFile rectanglesFile(rectanglesPath);
+        if(rectanglesFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            QTextStream stream(&rectanglesFile);
+            while(!stream.atEnd()) {
+                QStringList values = stream.readLine().simplified().split(' ');
+                if(values.size() == 4)
+                    cells.append(QRect(values.at(0).toInt(), values.at(1).toInt(), values.at(2).toInt(), values.at(3).toInt()));
+            }
+        }
+
+        if(cells.isEmpty())
+            std::cout << "[Atlas] No rectangles in " << rectanglesPath.toStdString() << ", using the grid" << std::endl;
+        else if(lodFullSize.isValid())
+            cells = AtlasProcessor(cells).scaled(lodFullSize.width(), lodFullSize.height(), input.width(), input.height()).getCells();
+    }
+
+    if(cells.isEmpty())
+        cells = AtlasProcessor::grid(input.width(), input.height(), ui->spinBox_atlasColumns->value(), ui->spinBox_atlasRows->value());
+
+    return cells;
+}
+
+void MainWindow::changeAtlasRectanglesDialog() {
+    QString path = QFileDialog::getOpenFileName(this,
+                                                "Choose Atlas Rectangles (one \"x y width height\" line per cell)",
+                                                ui->lineEdit_atlasRectangles->text(),
+                                                "Text Files (*.txt);;All Files (*)");
+    if(path.isEmpty())
+        return;
+
+    ui->lineEdit_atlasRectangles->setText(path);
+    ui->checkBox_atlas->setChecked(true);
+    autoUpdate();
+}
+
+void MainWindow::changeBaseNormalmapDialog() {
+    QString filter = "Image Formats (" + supportedImageformats.join(" ") + ")";
+    QString path = QFileDialog::getOpenFileName(this,
+                                                "Choose Base Normalmap (or enter a folder for matched pairs)",
+                                                ui->lineEdit_baseNormalmap->text(),
+                                                filter);
+    if(path.isEmpty())
+        return;
+
+    ui->lineEdit_baseNormalmap->setText(path);
+    ui->checkBox_combineBaseNormalmap->setChecked(true);
+    autoUpdate();
+}
+
+//the maps were calculated from the other version of the input
+void MainWindow::makeSeamlessToggled(bool on) {
+    //a seamless texture is tileable
+    if(on) {
+        ui->checkBox_tileable->setChecked(true);
+        ui->checkBox_displace_blur_tileable->setChecked(true);
+    }
+
+    clearMaps();
+
+    if(!input.isNull())
+        preview();
+}
+
+//all generated maps are calculated again when they are needed
+void MainWindow::clearMaps() {
+    normalmap = QImage();
+    normalField = NormalField();
+    curvaturemap = QImage();
+    roughnessmap = QImage();
+    horizonmap0 = QImage();
+    horizonmap1 = QImage();
+    conemap = QImage();
+    distancemap = QImage();
+    specmap = QImage();
+    displacementmap = QImage();
+    ssaomap = QImage();
 }
 
 void MainWindow::calcSpec() {
-    if(input.isNull())
+    if(input.isNull() || generatorRunning)
         return;
 
     //color channel mode
@@ -355,12 +786,35 @@ void MainWindow::calcSpec() {
 
     //setup generator and calculate map
     SpecularmapGenerator specularmapGenerator(mode, redMultiplier, greenMultiplier, blueMultiplier, alphaMultiplier);
-    specmap = specularmapGenerator.calculateSpecmap(input, scale, contrast);
+    specularmapGenerator.setProgress(&generatorProgress);
+    const bool fixedPoint = useFixedPoint();
+    const bool seamless = ui->checkBox_makeSeamless->isChecked();
+    const bool skipTransparent = ui->checkBox_skipTransparent->isChecked();
+    QImage result;
+
+    bool finished = runGenerator([&]() {
+        QImage source = generatorInput(seamless);
+        if(generatorProgress.isCanceled())
+            return;
+
+        const TileMask tileMask = (skipTransparent && source.hasAlphaChannel())
+                ? TileMask(source, source.width(), source.height()) : TileMask();
+        specularmapGenerator.setTileMask(&tileMask);
+
+        if(fixedPoint)
+            result = specularmapGenerator.calculateSpecmapFixedPoint(source, scale, contrast);
+        else
+            result = specularmapGenerator.calculateSpecmap(source, scale, contrast);
+    });
+
+    if(finished)
+        specmap = result;
 }
 
-//the displacement map is generated with the specularmapGenerator (similar controls and output needed)
+//the displacement map is generated with the specularmapGenerator (similar controls and output needed),
+//a normalmap as input is first integrated into a height field
 void MainWindow::calcDisplace() {
-    if(input.isNull())
+    if(input.isNull() || generatorRunning)
         return;
 
     //color channel mode
@@ -378,43 +832,296 @@ void MainWindow::calcDisplace() {
     double scale = ui->doubleSpinBox_displace_scale->value();
     double contrast = ui->doubleSpinBox_displace_contrast->value();
 
-    //setup generator and calculate map
+    //blur settings
+    bool blur = ui->checkBox_displace_blur->isChecked();
+    int radius = std::max(qRound(ui->spinBox_displace_blurRadius->value() * lodScale()), 1);
+    bool tileable = ui->checkBox_displace_blur_tileable->isChecked();
+    //borders when integrating a normalmap, like for the other maps generated from the input
+    const bool integrateTileable = ui->checkBox_tileable->isChecked();
+    bool fromNormalmap = ui->checkBox_displace_fromNormalmap->isChecked();
+
+    //setup generators and calculate map
+    HeightmapGenerator heightmapGenerator;
+    heightmapGenerator.setProgress(&generatorProgress);
     SpecularmapGenerator specularmapGenerator(mode, redMultiplier, greenMultiplier, blueMultiplier, alphaMultiplier);
-    displacementmap = specularmapGenerator.calculateSpecmap(input, scale, contrast);
+    specularmapGenerator.setProgress(&generatorProgress);
+    GaussianBlur filter;
+    filter.setProgress(&generatorProgress);
+    const bool fixedPoint = useFixedPoint();
+    const bool seamless = ui->checkBox_makeSeamless->isChecked();
+    const bool skipTransparent = ui->checkBox_skipTransparent->isChecked();
+    QImage result;
+
+    //the displacement of an image or of an atlas cell, with its own generators
+    auto calculate = [&](QImage source, HeightmapGenerator &heightmapGenerator,
+                         SpecularmapGenerator &specularmapGenerator, GaussianBlur &filter) -> QImage {
+        //from the alpha of the input, the integrated height has none
+        const TileMask tileMask = (skipTransparent && source.hasAlphaChannel())
+                ? TileMask(source, source.width(), source.height()) : TileMask();
+        specularmapGenerator.setTileMask(&tileMask);
+
+        if(fromNormalmap) {
+            //the integrated height stays in floating point until the map is written, 8 bit steps
+            //would show as terraces on smooth normals after brightness, contrast and blur
+            IntensityMap height;
+            if(!generatorProgress.isCanceled())
+                height = heightmapGenerator.calculateHeightmap(NormalField(source), integrateTileable);
+            if(generatorProgress.isCanceled())
+                return QImage();
+
+            IntensityMap displacement = specularmapGenerator.calculateSpecmap(height, scale, contrast);
+            specularmapGenerator.setTileMask(0);
+
+            if(blur && !generatorProgress.isCanceled())
+                displacement = filter.calculate(displacement, radius, tileable);
+
+            return displacement.convertToQImage();
+        }
 
-    if(ui->checkBox_displace_blur->isChecked()) {
-        int radius = ui->spinBox_displace_blurRadius->value();
-        bool tileable = ui->checkBox_displace_blur_tileable->isChecked();
+        QImage displacement;
+        if(generatorProgress.isCanceled())
+            return displacement;
 
-        IntensityMap inputMap(displacementmap, IntensityMap::AVERAGE);
-        GaussianBlur filter;
-        IntensityMap outputMap = filter.calculate(inputMap, radius, tileable);
-        displacementmap = outputMap.convertToQImage();
+        if(fixedPoint)
+            displacement = specularmapGenerator.calculateSpecmapFixedPoint(source, scale, contrast);
+        else
+            displacement = specularmapGenerator.calculateSpecmap(source, scale, contrast);
+        specularmapGenerator.setTileMask(0);
+
+        if(blur && !generatorProgress.isCanceled()) {
+            IntensityMap inputMap(displacement, IntensityMap::AVERAGE);
+            IntensityMap outputMap = filter.calculate(inputMap, radius, tileable);
+            displacement = outputMap.convertToQImage();
+        }
+
+        return displacement;
+    };
+    const QList<QRect> cells = atlasCells();
+
+    bool finished = runGenerator([&]() {
+        //brightness and contrast are applied to the integrated height like to an input image
+        QImage source = generatorInput(seamless);
+
+        if(cells.isEmpty()) {
+            result = calculate(source, heightmapGenerator, specularmapGenerator, filter);
+            return;
+        }
+
+        result = AtlasProcessor(cells).process(source, [&](const QImage &cell, int) -> QImage {
+            HeightmapGenerator cellHeightmapGenerator(heightmapGenerator);
+            SpecularmapGenerator cellSpecularmapGenerator(specularmapGenerator);
+            GaussianBlur cellFilter(filter);
+            return calculate(cell, cellHeightmapGenerator, cellSpecularmapGenerator, cellFilter);
+        });
+    });
+
+    if(finished)
+        displacementmap = result;
+}
+
+//the parallax maps are only calculated for saving, they are recalculated with the new depth then
+void MainWindow::clearParallaxMaps() {
+    horizonmap0 = QImage();
+    horizonmap1 = QImage();
+    conemap = QImage();
+}
+
+//horizon maps from the height the normalmap was calculated from
+void MainWindow::calcHorizon() {
+    if(input.isNull() || generatorRunning)
+        return;
+
+    if(normalmapRawIntensity.isNull() || normalmap.isNull()) {
+        calcNormal();
+        if(normalmapRawIntensity.isNull())
+            return;
     }
+
+    bool tileable = ui->checkBox_tileable->isChecked();
+    double depth = ui->doubleSpinBox_parallaxDepth->value() / 100.0 * normalmapRawIntensity.getWidth();
+
+    HorizonMapGenerator horizonMapGenerator;
+    horizonMapGenerator.setProgress(&generatorProgress);
+    QImage result0;
+    QImage result1;
+
+    bool finished = runGenerator([&]() {
+        result0 = horizonMapGenerator.calculateHorizonMap(normalmapRawIntensity, depth, tileable, HorizonMapGenerator::EAST);
+        result1 = horizonMapGenerator.calculateHorizonMap(normalmapRawIntensity, depth, tileable, HorizonMapGenerator::WEST);
+    });
+
+    if(finished) {
+        horizonmap0 = result0;
+        horizonmap1 = result1;
+    }
+}
+
+//signed distance field of the alpha channel
+void MainWindow::calcDistanceField() {
+    if(input.isNull() || generatorRunning)
+        return;
+
+    double spread = ui->spinBox_distanceSpread->value() * lodScale();
+    bool sixteenBit = ui->checkBox_distance16Bit->isChecked();
+    bool tileable = ui->checkBox_tileable->isChecked();
+    const bool seamless = ui->checkBox_makeSeamless->isChecked();
+
+    DistanceFieldGenerator distanceFieldGenerator;
+    distanceFieldGenerator.setProgress(&generatorProgress);
+    QImage result;
+
+    bool finished = runGenerator([&]() {
+        result = distanceFieldGenerator.calculateDistanceField(generatorInput(seamless), spread, tileable, sixteenBit);
+    });
+
+    if(finished)
+        distancemap = result;
+}
+
+void MainWindow::clearDistanceField() {
+    distancemap = QImage();
+}
+
+//cone step map from the height the normalmap was calculated from
+void MainWindow::calcCone() {
+    if(input.isNull() || generatorRunning)
+        return;
+
+    if(normalmapRawIntensity.isNull() || normalmap.isNull()) {
+        calcNormal();
+        if(normalmapRawIntensity.isNull())
+            return;
+    }
+
+    bool tileable = ui->checkBox_tileable->isChecked();
+
+    ConeMapGenerator coneMapGenerator;
+    coneMapGenerator.setProgress(&generatorProgress);
+    QImage result;
+
+    bool finished = runGenerator([&]() {
+        result = coneMapGenerator.calculateConeMap(normalmapRawIntensity, tileable);
+    });
+
+    if(finished)
+        conemap = result;
 }
 
 void MainWindow::calcSsao() {
-    if(input.isNull())
+    if(input.isNull() || generatorRunning)
         return;
 
     //if no normalmap was created yet, calculate it
     if(normalmap.isNull()) {
         calcNormal();
+
+        if(normalmap.isNull())
+            return;
     }
 
-    //scale depthmap (can be smaller than normalmap because of KeepLargeDetail
-    normalmapRawIntensity = normalmapRawIntensity.scaled(normalmap.width(), normalmap.height());
     float size = ui->doubleSpinBox_ssao_size->value();
     unsigned int samples = ui->spinBox_ssao_samples->value();
     unsigned int noiseTexSize = ui->spinBox_ssao_noiseTexSize->value();
 
+    bool tileable = ui->checkBox_tileable->isChecked();
+    const bool seamless = ui->checkBox_makeSeamless->isChecked();
+    const bool skipTransparent = ui->checkBox_skipTransparent->isChecked();
+
     //setup generator and calculate map
     SsaoGenerator ssaoGenerator;
-    ssaomap = ssaoGenerator.calculateSsaomap(normalmap, normalmapRawIntensity, size, samples, noiseTexSize);
+    ssaoGenerator.setProgress(&generatorProgress);
+    QImage result;
+
+    bool finished = runGenerator([&]() {
+        //the normalmap can be smaller than the input
+        const QImage source = skipTransparent ? generatorInput(seamless) : QImage();
+        const TileMask tileMask = (skipTransparent && source.hasAlphaChannel())
+                ? TileMask(source, normalmap.width(), normalmap.height()) : TileMask();
+        ssaoGenerator.setTileMask(&tileMask);
+
+        //scale depthmap (can be smaller than normalmap because of KeepLargeDetail)
+        IntensityMap depth = normalmapRawIntensity;
+        if((int)depth.getWidth() != normalmap.width() || (int)depth.getHeight() != normalmap.height())
+            depth = Resampler(Resampler::BILINEAR, tileable).scaled(depth, normalmap.width(), normalmap.height());
+
+        result = ssaoGenerator.calculateSsaomap(normalField, depth, size, samples, noiseTexSize, tileable);
+    });
+
+    if(finished)
+        ssaomap = result;
+}
+
+// Runs a map calculation on a worker thread. Until it is finished the ui keeps processing events
+// and polls the generator progress at a fixed rate, the generators themselves only update atomic counters.
+// Returns false if the calculation was canceled, its result is incomplete then.
+bool MainWindow::runGenerator(std::function<void()> job) {
+    generatorRunning = true;
+    generatorProgress.reset();
+    generatorProgressBar->setValue(0);
+    generatorProgressBar->show();
+
+    //the stop button cancels single maps too
+    const bool stopButtonEnabled = ui->pushButton_stopProcessingQueue->isEnabled();
+    ui->pushButton_stopProcessingQueue->setEnabled(true);
+
+    QEventLoop loop;
+    QFutureWatcher<void> watcher;
+    connect(&watcher, SIGNAL(finished()), &loop, SLOT(quit()));
+
+    QTimer pollTimer;
+    connect(&pollTimer, SIGNAL(timeout()), this, SLOT(updateGeneratorProgress()));
+    pollTimer.start(50);
+
+    generatorFuture = QtConcurrent::run(job);
+    watcher.setFuture(generatorFuture);
+    loop.exec();
+
+    //the loop also ends when the application quits. The job uses locals of the caller,
+    //so it is stopped and must be finished before returning
+    if(!watcher.isFinished())
+        generatorProgress.cancel();
+    watcher.waitForFinished();
+
+    pollTimer.stop();
+    ui->pushButton_stopProcessingQueue->setEnabled(stopButtonEnabled);
+    generatorProgressBar->hide();
+    generatorRunning = false;
+
+    return !generatorProgress.isCanceled();
+}
+
+//the image the maps are calculated from. With "Make Seamless" it is the input blended into a tileable texture,
+//which is kept until another image is loaded. Called inside the jobs of runGenerator
+QImage MainWindow::generatorInput(bool seamless) {
+    if(!seamless)
+        return input;
+
+    if(seamlessInput.isNull() || seamlessInputKey != input.cacheKey()) {
+        SeamlessTileMaker tileMaker;
+        tileMaker.setProgress(&generatorProgress);
+        QImage result = tileMaker.makeSeamless(input);
+
+        //an incomplete result is not kept
+        if(generatorProgress.isCanceled())
+            return result;
+
+        seamlessInput = result;
+        seamlessInputKey = input.cacheKey();
+    }
+
+    return seamlessInput;
+}
+
+void MainWindow::updateGeneratorProgress() {
+    generatorProgressBar->setValue((int)(generatorProgress.getProgress() * 100.0));
 }
 
 
 void MainWindow::calcNormalAndPreview() {
+    //another map is still calculated
+    if(generatorRunning)
+        return;
+
     ui->statusBar->showMessage("calculating normalmap...");
 
     //timer for measuring calculation time
@@ -424,6 +1131,11 @@ void MainWindow::calcNormalAndPreview() {
     //calculate map
     calcNormal();
 
+    if(generatorProgress.isCanceled()) {
+        ui->statusBar->showMessage("calculation of the normalmap was canceled", 5000);
+        return;
+    }
+
     //display time it took to calculate the map
     this->lastCalctime_normal = timer.elapsed();
     displayCalcTime(lastCalctime_normal, "normalmap", 5000);
@@ -436,6 +1148,10 @@ void MainWindow::calcNormalAndPreview() {
 }
 
 void MainWindow::calcSpecAndPreview() {
+    //another map is still calculated
+    if(generatorRunning)
+        return;
+
     ui->statusBar->showMessage("calculating specularmap...");
 
     //timer for measuring calculation time
@@ -445,6 +1161,11 @@ void MainWindow::calcSpecAndPreview() {
     //calculate map
     calcSpec();
 
+    if(generatorProgress.isCanceled()) {
+        ui->statusBar->showMessage("calculation of the specularmap was canceled", 5000);
+        return;
+    }
+
     //display time it took to calculate the map
     this->lastCalctime_specular = timer.elapsed();
     displayCalcTime(lastCalctime_specular, "specularmap", 5000);
@@ -457,6 +1178,10 @@ void MainWindow::calcSpecAndPreview() {
 }
 
 void MainWindow::calcDisplaceAndPreview() {
+    //another map is still calculated
+    if(generatorRunning)
+        return;
+
     ui->statusBar->showMessage("calculating displacementmap...");
 
     //timer for measuring calculation time
@@ -466,6 +1191,11 @@ void MainWindow::calcDisplaceAndPreview() {
     //calculate map
     calcDisplace();
 
+    if(generatorProgress.isCanceled()) {
+        ui->statusBar->showMessage("calculation of the displacementmap was canceled", 5000);
+        return;
+    }
+
     //display time it took to calculate the map
     this->lastCalctime_displace = timer.elapsed();
     displayCalcTime(lastCalctime_displace, "displacementmap", 5000);
@@ -478,6 +1208,10 @@ void MainWindow::calcDisplaceAndPreview() {
 }
 
 void MainWindow::calcSsaoAndPreview() {
+    //another map is still calculated
+    if(generatorRunning)
+        return;
+
     ui->statusBar->showMessage("calculating ambient occlusion map...");
 
     //timer for measuring calculation time
@@ -487,6 +1221,11 @@ void MainWindow::calcSsaoAndPreview() {
     //calculate map
     calcSsao();
 
+    if(generatorProgress.isCanceled()) {
+        ui->statusBar->showMessage("calculation of the ambient occlusion map was canceled", 5000);
+        return;
+    }
+
     //display time it took to calculate the map
     this->lastCalctime_ssao = timer.elapsed();
     displayCalcTime(lastCalctime_ssao, "ambient occlusion map", 5000);
@@ -499,15 +1238,11 @@ void MainWindow::calcSsaoAndPreview() {
 }
 
 void MainWindow::processQueue() {
-    if(ui->listWidget_queue->count() == 0)
+    if(ui->listWidget_queue->count() == 0 || generatorRunning)
         return;
 
-    if(!(ui->checkBox_queue_generateNormal->isChecked() ||
-         ui->checkBox_queue_generateSpec->isChecked() ||
-         ui->checkBox_queue_generateDisplace->isChecked())) {
-        QMessageBox::information(this, "Nothing to do", "Select at least one map type to generate from the \"Save\" section");
+    if(!mapsToSaveSelected())
         return;
-    }
 
     if(!exportPath.isValid()) {
         QMessageBox::information(this, "Invalid Export Path", "Export path is invalid!");
@@ -515,10 +1250,12 @@ void MainWindow::processQueue() {
     }
 
     //enable stop button
+    stopQueue = false;
     ui->pushButton_stopProcessingQueue->setEnabled(true);
     //show progress bar and adjust maximum to queue size
     ui->progressBar_Queue->show();
     ui->progressBar_Queue->setMaximum(ui->listWidget_queue->count());
+    BufferPool::instance().resetStats();
 
     for(int i = 0; i < ui->listWidget_queue->count() && !stopQueue; i++)
     {
@@ -542,6 +1279,12 @@ void MainWindow::processQueue() {
         QCoreApplication::processEvents();
     }
 
+    //report how many of the large temporary buffers were recycled
+    BufferPool::Stats poolStats = BufferPool::instance().getStats();
+    std::cout << "[Queue] Buffer pool: " << poolStats.hits << " buffers reused, "
+              << poolStats.misses << " allocated, ~" << poolStats.pageFaultsAvoided
+              << " page faults avoided" << std::endl;
+
     //disable stop button
     ui->pushButton_stopProcessingQueue->setEnabled(false);
     stopQueue = false;
@@ -552,9 +1295,205 @@ void MainWindow::processQueue() {
     ui->pushButton_openExportFolder->setEnabled(true);
 }
 
+//false (with a message) if no map type is selected in the "Save" section
+bool MainWindow::mapsToSaveSelected() {
+    if(!(ui->checkBox_queue_generateNormal->isChecked() ||
+         ui->checkBox_queue_generateSpec->isChecked() ||
+         ui->checkBox_queue_generateDisplace->isChecked() ||
+         ui->checkBox_queue_generateCurvature->isChecked() ||
+         ui->checkBox_queue_generateRoughness->isChecked() ||
+         ui->checkBox_queue_generateHorizon->isChecked() ||
+         ui->checkBox_queue_generateCone->isChecked() ||
+         ui->checkBox_queue_generateDistance->isChecked())) {
+        QMessageBox::information(this, "Nothing to do", "Select at least one map type to generate from the \"Save\" section");
+        return false;
+    }
+
+    return true;
+}
+
+//UDIM set: every tile is calculated with a halo of its neighbours (no seams at the tile borders)
+//and its maps are saved to the export path as name_normal.1001.png ...
+void MainWindow::processUdimSet() {
+    if(generatorRunning || !mapsToSaveSelected())
+        return;
+
+    if(!exportPath.isValid()) {
+        QMessageBox::information(this, "Invalid Export Path", "Export path is invalid!");
+        return;
+    }
+
+    QString filter = "Image Formats (" + supportedImageformats.join(" ") + ")";
+    QString tilePath = QFileDialog::getOpenFileName(this, "Open a Tile of the UDIM Set",
+                                                    QDir::homePath(), filter);
+    if(tilePath.isEmpty())
+        return;
+
+    UdimSet udimSet(tilePath);
+    if(udimSet.isEmpty()) {
+        QMessageBox::information(this, "No UDIM Set",
+                                 "The file name has no UDIM number (e.g. name.1001.png or name_1001.png)");
+        return;
+    }
+
+    const QList<int> tiles = udimSet.getTiles();
+    const int halo = ui->spinBox_udimHalo->value();
+    const QString exportName = exportPath.toLocalFile() + "/" + QFileInfo(udimSet.getPrefix()).fileName()
+            + "." + udimSet.getSuffix();
+
+    //the tiles are processed one after another, the generators already use all cores
+    //and only the neighbours of the current tile are kept in memory
+    stopQueue = false;
+    ui->pushButton_stopProcessingQueue->setEnabled(true);
+    ui->progressBar_Queue->show();
+    ui->progressBar_Queue->setMaximum(tiles.count());
+
+    for(int i = 0; i < tiles.count() && !stopQueue; i++) {
+        const int udim = tiles.at(i);
+
+        ui->statusBar->showMessage("Processing UDIM Tile " + QString::number(udim));
+        ui->progressBar_Queue->setValue(i + 1);
+
+        QImage tile = udimSet.loadWithHalo(udim, halo);
+        if(tile.isNull()) {
+            std::cout << "[UDIM] Tile " << udim << " could not be loaded" << std::endl;
+            continue;
+        }
+
+        input = tile;
+        loadedImagePath = QUrl::fromLocalFile(udimSet.getTilePath(udim));
+        showLoadedInput();
+
+        saveHalo = halo;
+        save(QUrl::fromLocalFile(exportName), "." + QString::number(udim));
+        saveHalo = 0;
+        std::cout << "[UDIM] Tile " << udim << " exported" << std::endl;
+
+        //user interface should stay responsive
+        QCoreApplication::processEvents();
+    }
+
+    ui->pushButton_stopProcessingQueue->setEnabled(false);
+    stopQueue = false;
+    ui->progressBar_Queue->hide();
+    ui->pushButton_openExportFolder->setEnabled(true);
+}
+
+//image sequence: the maps are saved with the frame numbers (fire_0001.png -> fire_normal_0001.png).
+//The next frame is decoded while the current one is calculated and its maps are written while
+//the next one is calculated. Frames with the same pixels as the previous one reuse its maps
+void MainWindow::processImageSequence() {
+    if(generatorRunning || !mapsToSaveSelected())
+        return;
+
+    if(!exportPath.isValid()) {
+        QMessageBox::information(this, "Invalid Export Path", "Export path is invalid!");
+        return;
+    }
+
+    QString filter = "Image Formats (" + supportedImageformats.join(" ") + ")";
+    QString framePath = QFileDialog::getOpenFileName(this, "Open a Frame of the Image Sequence",
+                                                     QDir::homePath(), filter);
+    if(framePath.isEmpty())
+        return;
+
+    const ImageSequence sequence(framePath);
+    if(sequence.isEmpty()) {
+        QMessageBox::information(this, "No Image Sequence",
+                                 "The file name has no frame number (e.g. name_0001.png)");
+        return;
+    }
+
+    const bool skipRepeated = ui->checkBox_sequenceSkipRepeated->isChecked();
+    const QString exportName = exportPath.toLocalFile() + "/" + QFileInfo(sequence.getPrefix()).fileName()
+            + "." + sequence.getSuffix();
+
+    stopQueue = false;
+    ui->pushButton_stopProcessingQueue->setEnabled(true);
+    ui->progressBar_Queue->show();
+    ui->progressBar_Queue->setMaximum(sequence.count());
+    writeMapsInBackground = true;
+
+    bool allWritten = true;
+    int repeatedFrames = 0;
+    //the last calculated frame
+    QByteArray previousHash;
+    QString previousNumber;
+    QStringList previousMaps;
+
+    QFuture<ImageSequence::Frame> nextFrame = QtConcurrent::run([&sequence]() { return sequence.loadFrame(0); });
+
+    for(int i = 0; i < sequence.count() && !stopQueue; i++) {
+        ImageSequence::Frame frame = nextFrame.result();
+        if(i + 1 < sequence.count())
+            nextFrame = QtConcurrent::run([&sequence, i]() { return sequence.loadFrame(i + 1); });
+
+        const QString number = sequence.getSeparator() + sequence.getFrameNumber(i);
+        ui->statusBar->showMessage("Processing Frame " + sequence.getFrameNumber(i));
+        ui->progressBar_Queue->setValue(i + 1);
+
+        if(frame.image.isNull()) {
+            std::cout << "[Sequence] Frame " << sequence.getFrameNumber(i).toStdString()
+                      << " could not be loaded" << std::endl;
+            continue;
+        }
+
+        //same pixels as the last calculated frame: copy its maps
+        if(skipRepeated && !previousMaps.isEmpty() && frame.hash == previousHash) {
+            allWritten &= finishMapWrites(pendingWrites);
+
+            foreach(const QString &path, previousMaps) {
+                const int numberPos = path.lastIndexOf(previousNumber + ".");
+                const QString copyPath = path.left(numberPos) + number + path.mid(numberPos + previousNumber.length());
+                QFile::remove(copyPath);
+                allWritten &= QFile::copy(path, copyPath);
+            }
+
+            repeatedFrames++;
+            continue;
+        }
+
+        input = frame.image;
+        loadedImagePath = QUrl::fromLocalFile(sequence.getFramePath(i));
+        showLoadedInput();
+
+        //the maps of the frame before are written while this one is calculated
+        QList<QFuture<bool> > previousWrites = pendingWrites;
+        pendingWrites.clear();
+        savedMapPaths.clear();
+        save(QUrl::fromLocalFile(exportName), number);
+        allWritten &= finishMapWrites(previousWrites);
+
+        previousHash = frame.hash;
+        previousNumber = number;
+        previousMaps = savedMapPaths;
+
+        //user interface should stay responsive
+        QCoreApplication::processEvents();
+    }
+
+    //the loader uses the sequence
+    nextFrame.waitForFinished();
+    allWritten &= finishMapWrites(pendingWrites);
+    writeMapsInBackground = false;
+    savedMapPaths.clear();
+
+    std::cout << "[Sequence] " << sequence.count() << " frames, " << repeatedFrames
+              << " repeated frames copied" << std::endl;
+    if(!allWritten)
+        QMessageBox::information(this, "Maps not saved", "One or more of the maps was NOT saved!");
+
+    ui->pushButton_stopProcessingQueue->setEnabled(false);
+    stopQueue = false;
+    ui->progressBar_Queue->hide();
+    ui->pushButton_openExportFolder->setEnabled(true);
+}
+
 //tell the queue to stop processing
 void MainWindow::stopProcessingQueue() {
     stopQueue = true;
+    //a running generator stops after its current row
+    generatorProgress.cancel();
 }
 
 //save maps using the file dialog
@@ -573,7 +1512,75 @@ void MainWindow::saveUserFilePath() {
     save(url);
 }
 
-void MainWindow::save(QUrl url) {
+//the part of a map that belongs to the UDIM tile, without the halo of its neighbours
+QImage MainWindow::cropSaveHalo(const QImage &map) {
+    if(saveHalo <= 0 || map.isNull())
+        return map;
+
+    //LOD variants are calculated from a smaller input, the halo is scaled with the map
+    const QSize fullSize = lodFullSize.isValid() ? lodFullSize : input.size();
+    return UdimSet::cropHalo(map, saveHalo, fullSize.width() - 2 * saveHalo, fullSize.height() - 2 * saveHalo);
+}
+
+//writes a map without the UDIM halo. While an image sequence is processed it is written
+//in the background and the result is known from finishMapWrites()
+bool MainWindow::writeMap(const QImage &map, const QString &path) {
+    const QImage cropped = cropSaveHalo(map);
+
+    if(!writeMapsInBackground)
+        return cropped.save(path);
+
+    savedMapPaths.append(path);
+    pendingWrites.append(QtConcurrent::run([cropped, path]() { return cropped.save(path); }));
+    return true;
+}
+
+//waits for maps written in the background, false if one of them was not saved
+bool MainWindow::finishMapWrites(QList<QFuture<bool> > &writes) {
+    bool written = true;
+    for(int i = 0; i < writes.size(); i++)
+        written &= writes[i].result();
+
+    writes.clear();
+    return written;
+}
+
+//saves a map, with edge padding if it is enabled. false if saving failed or the padding was canceled
+bool MainWindow::saveMap(const QImage &map, const QString &path) {
+    if(!ui->checkBox_edgePadding->isChecked() || map.isNull() || !input.hasAlphaChannel())
+        return writeMap(map, path);
+
+    //the nearest opaque pixels are kept for all maps of the same size. 0 is a full padding
+    const int width = ui->spinBox_edgePadding->value() == 0
+            ? 0 : std::max(qRound(ui->spinBox_edgePadding->value() * lodScale()), 1);
+    const bool tileable = ui->checkBox_tileable->isChecked();
+    const bool seamless = ui->checkBox_makeSeamless->isChecked();
+    const QString key = QString("%1 %2 %3 %4 %5 %6").arg(input.cacheKey()).arg(map.width()).arg(map.height())
+            .arg(width).arg(tileable).arg(seamless);
+
+    if(key != edgePaddingKey) {
+        edgePadding.setProgress(&generatorProgress);
+
+        bool finished = runGenerator([&]() {
+            QImage mask = generatorInput(seamless);
+            if(mask.size() != map.size())
+                mask = Resampler(Resampler::BILINEAR, tileable).scaled(mask, map.width(), map.height());
+            edgePadding.calculate(mask, width, tileable);
+        });
+
+        if(!finished) {
+            edgePaddingKey = QString();
+            return false;
+        }
+
+        edgePaddingKey = key;
+    }
+
+    return writeMap(edgePadding.apply(map), path);
+}
+
+//number: frame or UDIM tile number with its separator, inserted before the file suffix
+void MainWindow::save(QUrl url, QString number) {
     //if saving process was aborted or input image is empty
     if(!url.isValid() || input.isNull())
         return;
@@ -590,10 +1597,19 @@ void MainWindow::save(QUrl url) {
     if(suffix.toLower() == "tga")
         suffix = "png";
 
-    //append a suffix to the map names (result: path/original_normal.png)
-    QString name_normal = file.absolutePath() + "/" + file.baseName() + "_normal." + suffix;
-    QString name_specular = file.absolutePath() + "/" + file.baseName() + "_spec." + suffix;
-    QString name_displace = file.absolutePath() + "/" + file.baseName() + "_displace." + suffix;
+    //append a suffix to the map names (result: path/original_normal.png or path/original_normal.1001.png)
+    auto mapName = [&](const QString &type) {
+        return file.absolutePath() + "/" + file.baseName() + type + number + "." + suffix;
+    };
+    QString name_normal = mapName("_normal");
+    QString name_specular = mapName("_spec");
+    QString name_displace = mapName("_displace");
+    QString name_curvature = mapName("_curvature");
+    QString name_horizon0 = mapName("_horizon_0");
+    QString name_horizon1 = mapName("_horizon_1");
+    QString name_cone = mapName("_cone");
+    QString name_distance = mapName("_sdf");
+    QString name_roughness = mapName(ui->checkBox_roughnessGloss->isChecked() ? "_gloss" : "_roughness");
 
     bool successfullySaved = true;
     
@@ -601,27 +1617,108 @@ void MainWindow::save(QUrl url) {
         if(normalmap.isNull()) {
             ui->statusBar->showMessage("calculating normalmap...");
             calcNormal();
+
+            //stopped by the user, do not save the incomplete map
+            if(generatorProgress.isCanceled())
+                return;
         }
         
-        successfullySaved &= normalmap.save(name_normal);
+        successfullySaved &= saveMap(normalmap, name_normal);
     }    
     
     if(ui->checkBox_queue_generateSpec->isChecked()) {
         if(specmap.isNull()) {
             ui->statusBar->showMessage("calculating specularmap...");
             calcSpec();
+
+            //stopped by the user, do not save the incomplete map
+            if(generatorProgress.isCanceled())
+                return;
         }
         
-        successfullySaved &= specmap.save(name_specular);
+        successfullySaved &= saveMap(specmap, name_specular);
     }
 
     if(ui->checkBox_queue_generateDisplace->isChecked()) {
         if(displacementmap.isNull()) {
             ui->statusBar->showMessage("calculating displacementmap...");
             calcDisplace();
+
+            //stopped by the user, do not save the incomplete map
+            if(generatorProgress.isCanceled())
+                return;
         }
         
-        successfullySaved &= displacementmap.save(name_displace);
+        successfullySaved &= saveMap(displacementmap, name_displace);
+    }
+
+    if(ui->checkBox_queue_generateCurvature->isChecked()) {
+        //calculated together with the normalmap
+        if(curvaturemap.isNull()) {
+            ui->statusBar->showMessage("calculating curvaturemap...");
+            calcNormal();
+
+            //stopped by the user, do not save the incomplete map
+            if(generatorProgress.isCanceled())
+                return;
+        }
+
+        successfullySaved &= saveMap(curvaturemap, name_curvature);
+    }
+
+    if(ui->checkBox_queue_generateRoughness->isChecked()) {
+        //calculated together with the normalmap
+        if(roughnessmap.isNull()) {
+            ui->statusBar->showMessage("calculating roughnessmap...");
+            calcNormal();
+
+            //stopped by the user, do not save the incomplete map
+            if(generatorProgress.isCanceled())
+                return;
+        }
+
+        successfullySaved &= saveMap(roughnessmap, name_roughness);
+    }
+
+    if(ui->checkBox_queue_generateHorizon->isChecked()) {
+        if(horizonmap0.isNull()) {
+            ui->statusBar->showMessage("calculating horizonmaps...");
+            calcHorizon();
+
+            //stopped by the user, do not save the incomplete maps
+            if(generatorProgress.isCanceled())
+                return;
+        }
+
+        successfullySaved &= saveMap(horizonmap0, name_horizon0);
+        successfullySaved &= saveMap(horizonmap1, name_horizon1);
+    }
+
+    if(ui->checkBox_queue_generateCone->isChecked()) {
+        if(conemap.isNull()) {
+            ui->statusBar->showMessage("calculating conemap...");
+            calcCone();
+
+            //stopped by the user, do not save the incomplete map
+            if(generatorProgress.isCanceled())
+                return;
+        }
+
+        successfullySaved &= saveMap(conemap, name_cone);
+    }
+
+    if(ui->checkBox_queue_generateDistance->isChecked()) {
+        if(distancemap.isNull()) {
+            ui->statusBar->showMessage("calculating distance field...");
+            calcDistanceField();
+
+            //stopped by the user, do not save the incomplete map
+            if(generatorProgress.isCanceled())
+                return;
+        }
+
+        //defined everywhere, not padded
+        successfullySaved &= writeMap(distancemap, name_distance);
     }
     
     if(successfullySaved)
@@ -633,6 +1730,76 @@ void MainWindow::save(QUrl url) {
     setExportPath(url.adjusted(QUrl::RemoveFilename | QUrl::StripTrailingSlash));
     //enable "Open Export Folder" gui button
     ui->pushButton_openExportFolder->setEnabled(true);
+
+    //smaller variants of all maps, each level is saved (and reported) by another save()
+    if(!lodFullSize.isValid() && ui->spinBox_lodLevels->value() > 0)
+        saveLods(url, number);
+}
+
+//LOD variants of the saved maps (name_normal_lod1.png ...), every level half the size of the one before.
+//The input of a level is downsampled from the level before, so all levels together cost about a third
+//more than the full size. Radii and the normal strength are scaled with the level, see lodScale()
+void MainWindow::saveLods(QUrl url, QString number) {
+    const int levels = ui->spinBox_lodLevels->value();
+
+    //the full size input and maps are restored afterwards
+    const QImage fullInput = input;
+    const QImage fullNormalmap = normalmap;
+    const NormalField fullNormalField = normalField;
+    const IntensityMap fullRawIntensity = normalmapRawIntensity;
+    const QImage fullCurvaturemap = curvaturemap;
+    const QImage fullRoughnessmap = roughnessmap;
+    const QImage fullHorizonmap0 = horizonmap0;
+    const QImage fullHorizonmap1 = horizonmap1;
+    const QImage fullConemap = conemap;
+    const QImage fullDistancemap = distancemap;
+    const QImage fullSpecmap = specmap;
+    const QImage fullDisplacementmap = displacementmap;
+    const QImage fullSsaomap = ssaomap;
+
+    lodFullSize = input.size();
+    QImage levelInput = input;
+
+    for(int level = 1; level <= levels; level++) {
+        if(levelInput.width() == 1 && levelInput.height() == 1)
+            break;
+
+        const int width = std::max(levelInput.width() / 2, 1);
+        const int height = std::max(levelInput.height() / 2, 1);
+        levelInput = Resampler(Resampler::BOX).scaled(levelInput, width, height);
+
+        input = levelInput;
+        clearMaps();
+        ui->statusBar->showMessage(QString("saving LOD %1 (%2 x %3 px)...").arg(level).arg(width).arg(height));
+        save(url, "_lod" + QString::number(level) + number);
+
+        //stopped by the user
+        if(generatorProgress.isCanceled())
+            break;
+    }
+
+    lodFullSize = QSize();
+    input = fullInput;
+    normalmap = fullNormalmap;
+    normalField = fullNormalField;
+    normalmapRawIntensity = fullRawIntensity;
+    curvaturemap = fullCurvaturemap;
+    roughnessmap = fullRoughnessmap;
+    horizonmap0 = fullHorizonmap0;
+    horizonmap1 = fullHorizonmap1;
+    conemap = fullConemap;
+    distancemap = fullDistancemap;
+    specmap = fullSpecmap;
+    displacementmap = fullDisplacementmap;
+    ssaomap = fullSsaomap;
+}
+
+//size of the input of a LOD variant relative to the full input, 1 outside of the LOD export
+double MainWindow::lodScale() {
+    if(!lodFullSize.isValid() || input.isNull())
+        return 1.0;
+
+    return (double)input.width() / lodFullSize.width();
 }
 
 bool MainWindow::setExportPath(QUrl path) {
@@ -902,6 +2069,31 @@ void MainWindow::normalmapSizeChanged() {
     ui->label_normalmapSize->setText(text);
 }
 
+// The integer pipeline is only used for images with 8 bits per channel,
+// higher bit depths would lose precision (Grayscale16 has a depth of only 16 bits)
+bool MainWindow::useFixedPoint() {
+    if(!ui->checkBox_fixedPoint->isChecked())
+        return false;
+
+    switch(input.format()) {
+    case QImage::Format_Mono:
+    case QImage::Format_MonoLSB:
+    case QImage::Format_Indexed8:
+    case QImage::Format_Grayscale8:
+    case QImage::Format_Alpha8:
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+    case QImage::Format_RGB888:
+    case QImage::Format_RGBX8888:
+    case QImage::Format_RGBA8888:
+    case QImage::Format_RGBA8888_Premultiplied:
+        return true;
+    default:
+        return false;
+    }
+}
+
 // Used to scale down the input image if a value less than 100 
 // is set in spinBox_normalmapSize. We have to make sure size is at least 1
 int MainWindow::calcPercentage(int value, int percentage) {
@@ -919,6 +2111,7 @@ void MainWindow::connectSignalSlots() {
     //connect signals/slots
     //load/save/open export folder
     connect(ui->pushButton_load, SIGNAL(clicked()), this, SLOT(loadUserFilePath()));
+    connect(ui->pushButton_photometricStereo, SIGNAL(clicked()), this, SLOT(loadPhotometricStereo()));
     connect(ui->pushButton_save, SIGNAL(clicked()), this, SLOT(saveUserFilePath()));
     connect(ui->pushButton_openExportFolder, SIGNAL(clicked()), this, SLOT(openExportFolder()));
     //zoom
@@ -970,6 +2163,23 @@ void MainWindow::connectSignalSlots() {
     connect(ui->checkBox_keepLargeDetail, SIGNAL(clicked()), this, SLOT(autoUpdate()));
     connect(ui->spinBox_largeDetailScale, SIGNAL(valueChanged(int)), this, SLOT(autoUpdate()));
     connect(ui->doubleSpinBox_largeDetailHeight, SIGNAL(valueChanged(double)), this, SLOT(autoUpdate()));
+    connect(ui->checkBox_highPass, SIGNAL(clicked()), this, SLOT(autoUpdate()));
+    connect(ui->spinBox_highPassRadius, SIGNAL(valueChanged(int)), this, SLOT(autoUpdate()));
+    connect(ui->spinBox_roughnessFootprint, SIGNAL(valueChanged(int)), this, SLOT(autoUpdate()));
+    connect(ui->doubleSpinBox_roughnessBase, SIGNAL(valueChanged(double)), this, SLOT(autoUpdate()));
+    connect(ui->checkBox_roughnessGloss, SIGNAL(clicked()), this, SLOT(autoUpdate()));
+    connect(ui->doubleSpinBox_parallaxDepth, SIGNAL(valueChanged(double)), this, SLOT(clearParallaxMaps()));
+    connect(ui->spinBox_distanceSpread, SIGNAL(valueChanged(int)), this, SLOT(clearDistanceField()));
+    connect(ui->checkBox_distance16Bit, SIGNAL(clicked()), this, SLOT(clearDistanceField()));
+    connect(ui->checkBox_tileable, SIGNAL(clicked()), this, SLOT(clearDistanceField()));
+    connect(ui->checkBox_tileable, SIGNAL(clicked()), this, SLOT(clearParallaxMaps()));
+    connect(ui->checkBox_skipTransparent, SIGNAL(clicked()), this, SLOT(autoUpdate()));
+    connect(ui->checkBox_denoise, SIGNAL(clicked()), this, SLOT(autoUpdate()));
+    connect(ui->spinBox_denoiseRadius, SIGNAL(valueChanged(int)), this, SLOT(autoUpdate()));
+    connect(ui->doubleSpinBox_denoiseEdge, SIGNAL(valueChanged(double)), this, SLOT(autoUpdate()));
+    connect(ui->checkBox_combineBaseNormalmap, SIGNAL(clicked()), this, SLOT(autoUpdate()));
+    connect(ui->lineEdit_baseNormalmap, SIGNAL(editingFinished()), this, SLOT(autoUpdate()));
+    connect(ui->checkBox_makeSeamless, SIGNAL(clicked(bool)), this, SLOT(makeSeamlessToggled(bool)));
     // displacement autoupdate
     connect(ui->doubleSpinBox_displace_redMul, SIGNAL(valueChanged(double)), this, SLOT(autoUpdate()));
     connect(ui->doubleSpinBox_displace_greenMul, SIGNAL(valueChanged(double)), this, SLOT(autoUpdate()));
@@ -980,8 +2190,11 @@ void MainWindow::connectSignalSlots() {
     connect(ui->checkBox_displace_blur, SIGNAL(stateChanged(int)), this, SLOT(autoUpdate()));
     connect(ui->checkBox_displace_blur_tileable, SIGNAL(stateChanged(int)), this, SLOT(autoUpdate()));
     connect(ui->spinBox_displace_blurRadius, SIGNAL(valueChanged(int)), this, SLOT(autoUpdate()));
+    connect(ui->checkBox_displace_fromNormalmap, SIGNAL(stateChanged(int)), this, SLOT(autoUpdate()));
     // ssao autoupdate
     connect(ui->doubleSpinBox_ssao_size, SIGNAL(valueChanged(double)), this, SLOT(autoUpdate()));
+    // integer pipeline autoupdate
+    connect(ui->checkBox_fixedPoint, SIGNAL(clicked()), this, SLOT(autoUpdate()));
     //graphicsview drag and drop
     connect(ui->graphicsView, SIGNAL(singleImageDropped(QUrl)), this, SLOT(loadSingleDropped(QUrl)));
     connect(ui->graphicsView, SIGNAL(multipleImagesDropped(QList<QUrl>)), this, SLOT(loadMultipleDropped(QList<QUrl>)));
@@ -993,8 +2206,16 @@ void MainWindow::connectSignalSlots() {
     //queue (item widget)
     connect(ui->pushButton_removeImagesFromQueue, SIGNAL(clicked()), this, SLOT(removeImagesFromQueue()));
     connect(ui->pushButton_processQueue, SIGNAL(clicked()), this, SLOT(processQueue()));
+    connect(ui->pushButton_udim, SIGNAL(clicked()), this, SLOT(processUdimSet()));
+    connect(ui->pushButton_sequence, SIGNAL(clicked()), this, SLOT(processImageSequence()));
     connect(ui->pushButton_stopProcessingQueue, SIGNAL(clicked()), this, SLOT(stopProcessingQueue()));
     connect(ui->pushButton_changeOutputPath_Queue, SIGNAL(clicked()), this, SLOT(changeOutputPathQueueDialog()));
+    connect(ui->pushButton_baseNormalmap, SIGNAL(clicked()), this, SLOT(changeBaseNormalmapDialog()));
+    connect(ui->pushButton_atlasRectangles, SIGNAL(clicked()), this, SLOT(changeAtlasRectanglesDialog()));
+    connect(ui->checkBox_atlas, SIGNAL(clicked()), this, SLOT(autoUpdate()));
+    connect(ui->spinBox_atlasColumns, SIGNAL(valueChanged(int)), this, SLOT(autoUpdate()));
+    connect(ui->spinBox_atlasRows, SIGNAL(valueChanged(int)), this, SLOT(autoUpdate()));
+    connect(ui->lineEdit_atlasRectangles, SIGNAL(editingFinished()), this, SLOT(autoUpdate()));
     connect(ui->lineEdit_outputPath, SIGNAL(editingFinished()), this, SLOT(editOutputPathQueue()));
     connect(ui->listWidget_queue, SIGNAL(itemDoubleClicked(QListWidgetItem*)), this, SLOT(queueItemDoubleClicked(QListWidgetItem*)));
     //queue drag and drop
@@ -1054,6 +2275,9 @@ void MainWindow::hideAdvancedSettings() {
 }
 
 void MainWindow::closeEvent(QCloseEvent* event) {
+    //the running generator stops after its current row
+    generatorProgress.cancel();
+    generatorFuture.waitForFinished();
     writeSettings();
 }
 
@@ -24,8 +24,14 @@
 
 #include <QMainWindow>
 #include <QUrl>
+#include <QProgressBar>
+#include <QFuture>
+#include <functional>
 #include "queueitem.h"
 #include "src_generators/intensitymap.h"
+#include "src_generators/normalfield.h"
+#include "src_generators/generatorprogress.h"
+#include "src_generators/edgepadding.h"
 
 namespace Ui {
 class MainWindow;
@@ -61,12 +67,28 @@ public slots:
 private:
     Ui::MainWindow *ui;
     QImage input;
+    //input made seamless, the cache key of the input it was made from
+    QImage seamlessInput;
+    qint64 seamlessInputKey;
     QImage channelIntensity;
     QImage normalmap;
+    NormalField normalField;
+    //normals measured by photometric stereo, they replace the calculated normals until a new image is loaded
+    NormalField photometricNormals;
+    QImage curvaturemap;
+    QImage roughnessmap;
+    QImage horizonmap0;
+    QImage horizonmap1;
+    QImage conemap;
+    QImage distancemap;
+    //nearest opaque pixels for the edge padding of the saved maps
+    EdgePadding edgePadding;
+    QString edgePaddingKey;
     QImage specmap;
     QImage displacementmap;
     QImage ssaomap;
-    QImage normalmapRawIntensity;
+    //height the normalmap was calculated from, kept in floating point for the parallax and AO maps
+    IntensityMap normalmapRawIntensity;
     QUrl loadedImagePath;
     QUrl exportPath;
     int lastCalctime_normal;
@@ -74,6 +96,20 @@ private:
     int lastCalctime_displace;
     int lastCalctime_ssao;
     bool stopQueue;
+    //border of neighbouring UDIM tiles around the input, cut off when the maps are saved
+    int saveHalo;
+    //image sequences: the maps of a frame are written while the next frame is calculated
+    bool writeMapsInBackground;
+    QList<QFuture<bool> > pendingWrites;
+    //paths of the maps of the current frame of an image sequence
+    QStringList savedMapPaths;
+    //size of the full input while the LOD variants are calculated from smaller versions of it
+    QSize lodFullSize;
+    GeneratorProgress generatorProgress;
+    //the job of runGenerator(), waited for before the window is closed
+    QFuture<void> generatorFuture;
+    QProgressBar *generatorProgressBar;
+    bool generatorRunning;
     QStringList supportedImageformats;
     bool useCustomUiColors;
     QColor uiColorMainDefault;
@@ -85,9 +121,15 @@ private:
 
     bool setExportPath(QUrl path);
     void calcNormal();
+    void calcPhotometricMaps();
     void calcSpec();
     void calcDisplace();
     void calcSsao();
+    void calcHorizon();
+    void calcCone();
+    void calcDistanceField();
+    bool runGenerator(std::function<void()> job);
+    QImage generatorInput(bool seamless);
     QString generateElapsedTimeMsg(int calcTimeMs, QString mapType);
     void connectSignalSlots();
     void hideAdvancedSettings();
@@ -96,16 +138,29 @@ private:
     void addImageToQueue(QUrl url);
     void addImageToQueue(QList<QUrl> urls);
     void saveQueueProcessed(QUrl folderPath);
-    void save(QUrl url);
+    void save(QUrl url, QString number = QString());
+    bool saveMap(const QImage &map, const QString &path);
+    QImage cropSaveHalo(const QImage &map);
+    bool writeMap(const QImage &map, const QString &path);
+    bool finishMapWrites(QList<QFuture<bool> > &writes);
+    void saveLods(QUrl url, QString number);
+    double lodScale();
+    void clearMaps();
+    bool mapsToSaveSelected();
     bool load(QUrl url);
+    void showLoadedInput();
     void loadAllFromDir(QUrl url);
     int calcPercentage(int value, int percentage);
+    bool useFixedPoint();
+    QString findBaseNormalmap();
+    QList<QRect> atlasCells();
     void setUiColors();
     void writeSettings();
     void readSettings();
 
 private slots:
     void loadUserFilePath();
+    void loadPhotometricStereo();
     void loadSingleDropped(QUrl url);
     void loadMultipleDropped(QList<QUrl> urls);
     void calcNormalAndPreview();
@@ -114,6 +169,9 @@ private slots:
     void calcSsaoAndPreview();
     void processQueue();
     void stopProcessingQueue();
+    void processUdimSet();
+    void processImageSequence();
+    void updateGeneratorProgress();
     void saveUserFilePath();
     void preview();
     void preview(int tab);
@@ -131,6 +189,11 @@ private slots:
     void removeImagesFromQueue();
     void changeOutputPathQueueDialog();
     void editOutputPathQueue();
+    void changeBaseNormalmapDialog();
+    void changeAtlasRectanglesDialog();
+    void makeSeamlessToggled(bool on);
+    void clearParallaxMaps();
+    void clearDistanceField();
     void queueItemDoubleClicked(QListWidgetItem *item);
     void normalmapSizeChanged();
     void showAboutDialog();